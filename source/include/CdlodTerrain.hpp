@@ -0,0 +1,107 @@
+/** @file CdlodTerrain.hpp
+ *  @brief Continuous distance-dependent level of detail terrain.
+ *
+ *  A quadtree covers the whole world. Every frame the nodes to draw are
+ *  picked by their distance to the camera, and all of them are drawn with
+ *  one shared grid mesh that the vertex shader places, displaces and
+ *  morphs between levels. Selection only descends into nodes that are in
+ *  range, so its cost follows the number of drawn nodes, not world size.
+ *
+ *  A quarter of a node that its finer level does not reach is drawn at
+ *  the node's own resolution, with a quarter of the grid, so it lines up
+ *  and morphs with the whole nodes of that level next to it.
+ *
+ *  Selection is incremental. Every picked node remembers how far the
+ *  camera can move before any range test that led to it could change,
+ *  since a distance changes at most as much as the camera moves. The
+ *  next selection keeps the nodes with some of that margin left, and
+ *  only goes over the others again, coarsening from the highest
+ *  ancestor that no longer splits or refining below the node.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef CDLODTERRAIN_HPP
+#define CDLODTERRAIN_HPP
+
+#include <set>
+#include <vector>
+#include <utility>
+
+#include <glad/glad.h>
+#include "glm/glm.hpp"
+
+#include "Shader.hpp"
+
+class CdlodTerrain{
+public:
+    // 'gridSize' (even) cells per node side, 'leafSize' world units per finest
+    // node, 'levels' quadtree levels with the root centered on 'center'
+    CdlodTerrain(int gridSize, float leafSize, int levels, glm::vec2 center);
+    // Release the grid mesh
+    ~CdlodTerrain();
+    // Pick the nodes to draw for a camera, terrain lies within [minHeight, maxHeight].
+    // Starts over from the root when the height range changes.
+    void Select(const glm::vec3& eye, float minHeight, float maxHeight);
+    // Draw the selected nodes, the shader must be bound
+    void Render(Shader& shader) const;
+    // Number of nodes picked by the last Select
+    int GetSelectedCount() const;
+    // Distance up to which the coarsest level is drawn
+    float GetViewDistance() const;
+
+private:
+    struct Node{
+        glm::vec2 origin;
+        float size;
+        int level;
+        // Only the quarter grid over the node, at the level's cell size
+        bool quarter;
+    };
+
+    // A quadtree node where the last selection stopped
+    struct Pick{
+        // Quadtree level, and position in nodes of that level from the root
+        int level;
+        glm::ivec2 index;
+        // How far the camera can still move before it has to be looked at
+        float slack;
+        // What is drawn for it, nothing for a root out of range
+        bool drawn;
+        Node node;
+    };
+
+    // Pick from node 'index' of 'level' down, whose ancestors all split
+    // and leave 'slack' of margin
+    void SelectNode(int level, glm::ivec2 index, float slack);
+    // Look at a pick whose margin ran out again
+    void Reselect(const Pick& pick);
+    // Distance from the camera to the node's box
+    float Distance(int level, glm::ivec2 index) const;
+    glm::vec2 NodeOrigin(int level, glm::ivec2 index) const;
+    float NodeSize(int level) const;
+
+    int m_gridSize;
+    float m_leafSize;
+    int m_levels;
+    glm::vec2 m_center;
+    // Furthest distance each level is drawn at, finest level first
+    std::vector<float> m_ranges;
+    std::vector<Pick> m_picks;
+    std::vector<Node> m_selected;
+    // Nodes already picked by this selection's Reselect calls
+    std::set<std::pair<int, std::pair<int, int>>> m_repicked;
+
+    // State of the current selection
+    glm::vec3 m_eye;
+    float m_minHeight;
+    float m_maxHeight;
+
+    GLuint m_VAO;
+    GLuint m_VBO;
+    GLuint m_EBO;
+    GLsizei m_indexCount;
+    // Indices of the quarter grid, right after the full grid's
+    GLsizei m_quarterCount;
+};
+
+#endif
@@ -0,0 +1,127 @@
+/** @file ChunkArena.hpp
+ *  @brief Shared GPU storage for terrain chunk meshes.
+ *
+ *  Rather than every chunk owning its own VAO, VBOs and EBO, the arena
+ *  keeps one large buffer per vertex attribute split into fixed-size
+ *  slots, plus one index buffer holding the index patterns that chunks
+ *  share. A chunk is drawn with a base-vertex offset into its slot.
+ *
+ *  Chunks with their own triangulation keep it in a range of the same
+ *  index buffer, handed out first-fit from a sorted free-list.
+ *
+ *  Uploads go through a ring of mapped staging regions, and a chunk's
+ *  attribute can be mapped so a generation kernel writes it in place.
+ *
+ *  The world origin of every slot is kept in a buffer texture. A vertex
+ *  finds its slot from gl_VertexID (which includes the base vertex), so
+ *  any number of chunks can be drawn in one multi-draw without a model
+ *  matrix per chunk.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef CHUNKARENA_HPP
+#define CHUNKARENA_HPP
+
+#include <vector>
+
+#include <glad/glad.h>
+#include "glm/glm.hpp"
+
+#include "FloatSpan.hpp"
+#include "StagingRing.hpp"
+
+class ChunkArena{
+public:
+    // Vertex attributes, matching the shader locations
+    static const int POSITION = 0;
+    static const int NORMAL = 1;
+    static const int COLOR = 2;
+
+    // Create an arena whose slots hold 'slotVertices' vertices each
+    ChunkArena(GLsizei slotVertices, int initialSlots);
+    // Release every buffer owned by the arena
+    ~ChunkArena();
+    // Reserve a slot for a chunk, growing the buffers when full
+    int Allocate();
+    // Return a slot to the free-list
+    void Free(int slot);
+    // Copy position, normal and color data (3 floats each) into a slot
+    void Upload(int slot, const float* positions, const float* normals, const float* colors);
+    // Copy a single attribute (3 floats per vertex) into a slot
+    void UploadAttribute(int slot, int attribute, const float* data);
+    // Staging memory to write a slot's attribute into (3 floats per vertex,
+    // write only), empty if it could not be mapped
+    FloatSpan MapAttribute(int slot, int attribute);
+    // Send what was written since MapAttribute to the slot, returns false
+    // if it could not be sent and has to be uploaded again
+    bool UnmapAttribute();
+    // World position the vertices of a slot are relative to
+    void SetOrigin(int slot, const glm::vec3& origin);
+    // Append an index pattern, returns the position of its first index
+    GLsizei AddIndices(const std::vector<int>& indices);
+    // Store indices in a free range of the index buffer, returns the
+    // position of the first one
+    GLsizei AllocateIndices(const std::vector<int>& indices);
+    // Same for 'count' indices, only ever copied bytewise from 'indices'
+    GLsizei AllocateIndices(const int* indices, GLsizei count);
+    // Return a range from AllocateIndices to the free-list
+    void FreeIndices(GLsizei first, GLsizei count);
+    // Bind the arena VAO (one per vertex format)
+    void Bind() const;
+    // Bind the slot origins as a buffer texture to 'textureUnit'
+    void BindOrigins(GLenum textureUnit) const;
+    // Draw 'count' indices starting at 'firstIndex' from the given slot
+    void Draw(int slot, GLsizei count, GLsizei firstIndex) const;
+    // Draw several index ranges, each from its own slot, in one call
+    void MultiDraw(const int* slots, const GLsizei* counts, const GLsizei* firstIndices, int drawCount) const;
+    // The first vertex of a slot inside the shared buffers
+    GLint GetBaseVertex(int slot) const;
+    // How many vertices fit in a single slot
+    GLsizei GetSlotVertices() const;
+    // How many slots the buffers currently hold
+    int GetCapacity() const;
+
+private:
+    // Resize every vertex buffer, keeping the slots already in use
+    void Grow(int newCapacity);
+    // Send m_indices[first, first + count) to the index buffer
+    void UploadIndices(GLsizei first, GLsizei count);
+    // Point the VAO attributes at the current buffers
+    void SetupVertexArray();
+
+    // Regions the size of one attribute of one slot, a few chunks' worth
+    static const int STAGING_REGIONS = 12;
+
+    // Number of vertices per slot
+    GLsizei m_slotVertices;
+    // Number of slots in the vertex buffers
+    int m_capacity;
+    // Slots that are not currently used by any chunk
+    std::vector<int> m_freeSlots;
+    struct IndexRange{
+        GLsizei first;
+        GLsizei count;
+    };
+
+    // Copy of everything in the index buffer
+    std::vector<int> m_indices;
+    // Number of indices the index buffer has room for
+    GLsizei m_indexCapacity;
+    // Unused ranges of the index buffer, sorted by position
+    std::vector<IndexRange> m_freeIndices;
+    // Uploads on their way to the vertex buffers, and where the mapped
+    // region goes
+    StagingRing m_staging;
+    int m_mappedSlot;
+    int m_mappedAttribute;
+    // One buffer each for positions, normals and colors
+    GLuint m_VBO[3];
+    GLuint m_EBO;
+    GLuint m_VAO;
+    // Origin of every slot (4 floats each) and the buffer texture reading it
+    std::vector<float> m_origins;
+    GLuint m_originBuffer;
+    GLuint m_originTexture;
+};
+
+#endif
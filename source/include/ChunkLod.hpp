@@ -0,0 +1,75 @@
+/** @file ChunkLod.hpp
+ *  @brief Geomipmapped levels of detail for terrain chunks.
+ *
+ *  Every level skips vertices with a stride of 2^level but keeps using the
+ *  chunk's full resolution vertex data, so levels only differ in their
+ *  index patterns. A chunk is drawn as an inner body plus four edge
+ *  strips, and every edge strip exists for each coarser neighbour level,
+ *  so neighbouring chunks at different levels always meet without cracks.
+ *
+ *  The body is laid out block by block, so blocks that need not be drawn
+ *  (under water) can be left out while the rest still merge into a few
+ *  ranges. Blocks are never narrower than a level's quads.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef CHUNKLOD_HPP
+#define CHUNKLOD_HPP
+
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "ChunkArena.hpp"
+
+class ChunkLod{
+public:
+    // Number of levels, level 0 is full resolution
+    static const int LEVELS = 6;
+    // Edges of a chunk, in the order the neighbours are looked up
+    static const int SOUTH = 0;
+    static const int EAST = 1;
+    static const int NORTH = 2;
+    static const int WEST = 3;
+
+    // Where one piece of a chunk mesh lives in the arena index buffer
+    struct Range{
+        GLsizei first = 0;
+        GLsizei count = 0;
+    };
+
+    // Build and upload the patterns for chunks of 'cells' x 'cells' quads,
+    // with bodies split in up to 'blocks' x 'blocks' blocks
+    ChunkLod(ChunkArena& arena, int cells, int blocks);
+    // The inner part of a chunk at a level
+    Range GetBody(int level) const;
+    // Blocks per side of a level's body, which divides 'blocks'
+    int GetBodyBlocks(int level) const;
+    // The part of a level's body in block (bx, by). Blocks follow each
+    // other in the index buffer row by row.
+    Range GetBodyBlock(int level, int bx, int by) const;
+    // The strip along one edge, stitched to a neighbour at 'neighborLevel'
+    Range GetEdge(int level, int side, int neighborLevel) const;
+    // Max height error of every level for a chunk's vertices (x, y, z)
+    static std::vector<float> ComputeErrors(const std::vector<float>& vertices, int cells);
+    // Coarsest level whose error stays under 'maxPixelError' on screen.
+    // 'projectionScale' is the viewport height / (2 * tan(fov / 2)).
+    static int SelectLevel(const std::vector<float>& errors, float distance, float projectionScale, float maxPixelError);
+
+private:
+    // Triangulate the strip between a chunk edge and the row 'stride' inside it
+    std::vector<int> BuildEdge(int stride, int side, int neighborStride) const;
+    // Triangulate the quads inside the edge strips that start within
+    // [x0, x1) x [y0, y1)
+    std::vector<int> BuildBody(int stride, int x0, int y0, int x1, int y1) const;
+    // Vertex index of grid point (t, d) measured along and into a side
+    int EdgeVertex(int side, int t, int d) const;
+
+    int m_cells;
+    Range m_bodies[LEVELS];
+    int m_bodyBlocks[LEVELS];
+    std::vector<Range> m_bodyBlockRanges[LEVELS];
+    Range m_edges[LEVELS][4][LEVELS];
+};
+
+#endif
@@ -0,0 +1,90 @@
+/** @file ChunkPipeline.hpp
+ *  @brief Memoized, dependency-aware chunk generation stages.
+ *
+ *  Each stage declares the parameters it depends on (as a Fingerprint)
+ *  and the stages it reads from. Stage outputs are cached per chunk
+ *  under a key made from the stage fingerprint and the chunk position,
+ *  so after a parameter change only the stages whose fingerprint moved
+ *  are run again.
+ *
+ *  Stages with a fixed output size can instead be given a kernel that
+ *  writes into a FloatSpan. Get still caches their output in a vector,
+ *  while Write runs the same kernel straight into the caller's memory,
+ *  such as a mapped GPU buffer, without keeping a copy.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef CHUNKPIPELINE_HPP
+#define CHUNKPIPELINE_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+
+#include "Fingerprint.hpp"
+#include "FloatSpan.hpp"
+
+class ChunkPipeline{
+public:
+    // Returns the fingerprint of everything a stage depends on
+    typedef std::function<Fingerprint()> ConfigFunction;
+    // Builds a stage's output for chunk (x, y) from the outputs of its inputs
+    typedef std::function<std::vector<float>(int x, int y, uint64_t key,
+                                             const std::vector<const std::vector<float>*>& inputs)> StageFunction;
+
+    // Writes a stage's output for chunk (x, y) into 'out', which holds
+    // exactly the stage's size in floats
+    typedef std::function<void(int x, int y, uint64_t key,
+                               const std::vector<const std::vector<float>*>& inputs, FloatSpan out)> WriteFunction;
+    // Add a stage, returns the id used to refer to it
+    int AddStage(const std::string& name, ConfigFunction config, const std::vector<int>& inputs, StageFunction compute);
+    // Add a stage whose output is always 'size' floats written by 'write'
+    int AddStage(const std::string& name, ConfigFunction config, const std::vector<int>& inputs, size_t size, WriteFunction write);
+    // Re-read the fingerprint of every stage, call after parameters change
+    void Refresh();
+    // Returns the cache key of a stage's output for chunk (x, y)
+    uint64_t GetKey(int stage, int x, int y) const;
+    // Returns a stage's output for chunk (x, y), running stages only if needed
+    const std::vector<float>& Get(int stage, int x, int y);
+    // Run a stage added with a WriteFunction into 'out' without caching
+    // the result, its inputs are still taken from (or added to) the cache.
+    // Returns false if the stage cannot be written or 'out' is too small.
+    bool Write(int stage, int x, int y, FloatSpan out);
+    // Drop every cached output of chunk (x, y)
+    void Evict(int x, int y);
+    // Number of times a stage actually ran since the last call
+    int TakeRunCount(int stage);
+    // Returns the name a stage was added with
+    const std::string& GetName(int stage) const;
+    // Number of stages added, their ids run from 0 up to it
+    int GetStageCount() const;
+
+private:
+    // Outputs of a stage's inputs for chunk (x, y)
+    std::vector<const std::vector<float>*> GetInputs(int stage, int x, int y);
+
+    // One cached stage output
+    struct Artifact{
+        uint64_t key = 0;
+        bool valid = false;
+        std::vector<float> data;
+    };
+
+    struct Stage{
+        std::string name;
+        ConfigFunction configFunction;
+        Fingerprint config;
+        std::vector<int> inputs;
+        StageFunction compute;
+        WriteFunction write;
+        size_t size = 0;
+        std::map<std::pair<int, int>, Artifact> artifacts;
+        int runs = 0;
+    };
+
+    std::vector<Stage> m_stages;
+};
+
+#endif
@@ -0,0 +1,82 @@
+/** @file ChunkStore.hpp
+ *  @brief Persistent on-disk storage for generated chunk data.
+ *
+ *  Chunks are grouped into region files of REGION_SIZE x REGION_SIZE
+ *  chunks. Every region file starts with a fixed header that indexes
+ *  where each chunk payload lives and how much room its slot has.
+ *  A payload that fits its chunk's slot is written over it, others
+ *  get a new slot at the end of the file, and a region whose dead
+ *  slots outgrow its live ones is compacted.
+ *
+ *  Region files are read through a memory mapping inside a reserved
+ *  address range, so a region that grows is mapped further in place
+ *  instead of being mapped again.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef CHUNKSTORE_HPP
+#define CHUNKSTORE_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+class ChunkStore{
+public:
+    // Number of chunks along each side of a region file
+    static const int REGION_SIZE = 32;
+
+    // One entry of the region header
+    struct RegionEntry{
+        uint64_t offset;
+        uint32_t size;
+        // Room of the slot, 0 for files that only stored the size
+        uint32_t reserved;
+    };
+
+    // Open (or create) a store that lives in 'directory'
+    ChunkStore(const std::string& directory);
+    // Unmap every region file
+    ~ChunkStore();
+    // Copy the payload of chunk (x, y) into 'out', returns false if missing
+    bool Load(int x, int y, std::vector<char>& out);
+    // Write the payload of chunk (x, y) to its region file
+    bool Save(int x, int y, const void* data, size_t size);
+    // Returns the directory the store writes to
+    const std::string& GetDirectory() const;
+
+private:
+    // A region file mapped into memory
+    struct MappedRegion{
+        const char* data = nullptr;
+        size_t size = 0;
+        // Address range set aside for the mapping to grow into
+        size_t reserved = 0;
+        // Kept open for writing chunks
+        int file = -1;
+        // Bytes of slots no chunk points to any more
+        size_t dead = 0;
+    };
+
+    // Path of the region file that holds region (rx, ry)
+    std::string RegionPath(int rx, int ry) const;
+    // Map a region file, returns nullptr if the file does not exist
+    MappedRegion* MapRegion(int rx, int ry);
+    // Map a region file, creating it with an empty header if needed
+    MappedRegion* CreateRegion(int rx, int ry);
+    // Map a region file up to 'size', keeping the address if it fits
+    bool GrowRegion(int rx, int ry, size_t size);
+    // Rewrite a region file with only the slots chunks point to
+    void CompactRegion(int rx, int ry);
+    // Drop the mapping of a region and close its file
+    void UnmapRegion(int rx, int ry);
+    // Logs an error message
+    void Log(const char* system, const char* message);
+
+    std::string m_directory;
+    std::map<std::pair<int, int>, MappedRegion> m_regions;
+};
+
+#endif
@@ -0,0 +1,73 @@
+/** @file FarFieldRing.hpp
+ *  @brief Coarse terrain tiles filling the distance beyond the chunks.
+ *
+ *  The world around the camera is split into square tiles sampled at a
+ *  low resolution from the same height function as the chunks. Only the
+ *  tiles reaching past the near terrain are drawn, as a ring, with one
+ *  multi-draw from a chunk arena of their own. Tiles are kept while they
+ *  stay in range and a few missing ones are generated every frame, so
+ *  the horizon fills in as the camera moves instead of stalling it.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef FARFIELDRING_HPP
+#define FARFIELDRING_HPP
+
+#include <map>
+#include <vector>
+#include <utility>
+#include <functional>
+
+#include "glm/glm.hpp"
+
+#include "ChunkArena.hpp"
+
+class FarFieldRing{
+public:
+    // Fills 'out' with width x height terrain heights, row by row, for
+    // the world positions (x + i * spacing, z + j * spacing)
+    typedef std::function<void(float x, float z, float spacing, int width, int height, float* out)> HeightFunction;
+    // Color of the terrain at a height
+    typedef std::function<glm::vec3(float height)> ColorFunction;
+
+    // Tiles of 'tileCells' cells 'spacing' world units wide, reaching
+    // 'radius' tiles from the camera
+    FarFieldRing(int tileCells, float spacing, int radius, HeightFunction heightFunction, ColorFunction colorFunction);
+    // Follow the camera: forget the tiles out of range and generate up to
+    // 'budget' missing ones. Tiles closer than 'innerRadius' are not needed.
+    void Update(const glm::vec3& eye, float innerRadius, int budget);
+    // Throw away every tile, e.g. after the terrain parameters changed
+    void Invalidate();
+    // Draw the ring, the terrain shader must be bound with an identity model matrix
+    void Render() const;
+    // Number of tiles drawn by Render
+    int GetTileCount() const;
+    // Distance up to which the ring reaches
+    float GetViewDistance() const;
+
+private:
+    typedef std::pair<int, int> TileKey;
+
+    // Generate a tile and upload it to a free slot
+    void GenerateTile(const TileKey& key);
+    // Horizontal distance from the eye to the nearest and furthest point of a tile
+    float NearestDistance(const TileKey& key, const glm::vec3& eye) const;
+    float FurthestDistance(const TileKey& key, const glm::vec3& eye) const;
+
+    int m_tileCells;
+    float m_spacing;
+    float m_tileSize;
+    int m_radius;
+    HeightFunction m_heightFunction;
+    ColorFunction m_colorFunction;
+
+    ChunkArena m_arena;
+    GLsizei m_indexFirst;
+    GLsizei m_indexCount;
+    // Slot of every generated tile
+    std::map<TileKey, int> m_tiles;
+    // Slots drawn this frame
+    std::vector<int> m_drawSlots;
+};
+
+#endif
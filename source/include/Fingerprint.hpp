@@ -0,0 +1,40 @@
+/** @file Fingerprint.hpp
+ *  @brief Stable hashing of generation parameters.
+ *
+ *  Values are fed in a fixed little-endian byte order and hashed with
+ *  64 bit FNV-1a, so the same parameters give the same fingerprint on
+ *  every machine and every run. Fingerprints are used as cache keys for
+ *  generated chunk data.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef FINGERPRINT_HPP
+#define FINGERPRINT_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class Fingerprint{
+public:
+    // Start a new fingerprint
+    Fingerprint();
+    // Mix values into the fingerprint
+    Fingerprint& Add(uint64_t value);
+    Fingerprint& Add(int value);
+    Fingerprint& Add(float value);
+    Fingerprint& Add(const std::string& value);
+    Fingerprint& Add(const std::vector<int>& values);
+    // Returns the 64 bit hash of everything added so far
+    uint64_t GetValue() const;
+    // Returns the hash as 16 hex digits
+    std::string ToString() const;
+
+private:
+    // Hash raw bytes in order
+    void AddBytes(const unsigned char* bytes, size_t count);
+
+    uint64_t m_hash;
+};
+
+#endif
@@ -0,0 +1,26 @@
+/** @file FloatSpan.hpp
+ *  @brief A run of floats that generation kernels write their output into.
+ *
+ *  The memory may belong to a vector or to a mapped GPU buffer, so the
+ *  same kernel can fill a cached artifact or write straight into a
+ *  staging region. Mapped memory must only be written, never read back.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef FLOATSPAN_HPP
+#define FLOATSPAN_HPP
+
+#include <vector>
+#include <cstddef>
+
+struct FloatSpan{
+    float* data;
+    size_t size;
+
+    FloatSpan(float* _data = nullptr, size_t _size = 0) : data(_data), size(_size) {}
+    FloatSpan(std::vector<float>& vector) : data(vector.data()), size(vector.size()) {}
+
+    float& operator[](size_t i) const { return data[i]; }
+};
+
+#endif
@@ -0,0 +1,85 @@
+/** @file FrameCapture.hpp
+ *  @brief Captures rendered frames without stalling the render thread.
+ *
+ *  Each frame is read back into the next pixel buffer of a ring, which
+ *  returns at once while the GPU does the copy. The buffer is mapped
+ *  only when its turn comes around again a few frames later, by when
+ *  the copy is long done, and the pixels are handed to a writer thread
+ *  that encodes them.
+ *
+ *  Frames are written either as one ASCII PPM per frame, in the same
+ *  form as the images in common/textures, or appended to a single file
+ *  of raw RGB frames (ffmpeg -f rawvideo -pix_fmt rgb24 -s WxH). When
+ *  the writer falls behind, frames are dropped rather than waited for.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef FRAMECAPTURE_HPP
+#define FRAMECAPTURE_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <glad/glad.h>
+
+class FrameCapture{
+public:
+    enum Format {
+        PPM_FRAMES, // One ASCII PPM per frame in a directory
+        RAW_VIDEO   // Every frame appended to one file of RGB bytes
+    };
+
+    // Frames of 'width' x 'height' through a ring of 'buffers' pixel
+    // buffers, with at most 'maxQueued' frames waiting for the writer
+    FrameCapture(int width, int height, int buffers, int maxQueued);
+    // Write out what is still in flight and release the buffers
+    ~FrameCapture();
+    // Start writing frames to 'path', a directory or a file by 'format'
+    void Start(Format format, const std::string& path);
+    // Write out the frames in flight and stop the writer
+    void Stop();
+    bool IsCapturing() const;
+    // Read back the frame just drawn, before it is swapped
+    void Capture();
+
+private:
+    struct Frame{
+        int number;
+        std::vector<unsigned char> pixels;
+    };
+
+    // Map the buffer read back 'buffers' frames ago and queue its pixels
+    void Collect(int buffer);
+    void WriterLoop();
+    void Write(const Frame& frame);
+    void Log(const char* system, const char* message);
+
+    int m_width;
+    int m_height;
+    int m_maxQueued;
+    Format m_format;
+    std::string m_path;
+    bool m_capturing;
+
+    // Ring of pixel buffers and the frame read into each, -1 if none
+    std::vector<GLuint> m_buffers;
+    std::vector<int> m_bufferFrames;
+    int m_frame;
+    int m_dropped;
+
+    // Frames waiting to be written, and pixel vectors to reuse
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Frame> m_queue;
+    std::vector<std::vector<unsigned char>> m_free;
+    bool m_stop;
+    std::ofstream m_video;
+};
+
+#endif
@@ -0,0 +1,60 @@
+/** @file FrameClock.hpp
+ *  @brief Fixed timestep updates, frame pacing and frame time statistics.
+ *
+ *  Every frame hands the time it took to an accumulator that is spent in
+ *  updates of one fixed step, so the simulation runs at the same speed
+ *  whatever the frame rate. What is left over is the fraction of a step
+ *  the rendered frame lies past the last update, to interpolate with.
+ *
+ *  Frame times are kept for the last frames so their spread can be
+ *  reported, and frames can be held back to a maximum rate.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef FRAMECLOCK_HPP
+#define FRAMECLOCK_HPP
+
+#include <vector>
+#include <chrono>
+
+class FrameClock{
+public:
+    // Frame times over the kept history, in milliseconds
+    struct Stats{
+        int frames;
+        double average;
+        double best;
+        double worst;
+        // 99% of the frames were at least this fast
+        double percentile99;
+    };
+
+    // Updates of 'step' seconds, keeping the times of the last 'history' frames
+    FrameClock(double step, int history);
+    // Start a frame, adding the time since the last one to the accumulator
+    void BeginFrame();
+    // Whether an update is due, taking its step out of the accumulator
+    bool Step();
+    // Seconds of a single update
+    double GetStep() const;
+    // How far past the last update the frame lies, from 0 to 1
+    float GetAlpha() const;
+    // Wait until the frame has lasted 1/'maxFps' seconds, 0 does not wait
+    void Pace(double maxFps);
+    // Statistics of the kept frame times
+    Stats GetStats() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    double m_step;
+    double m_accumulator;
+    Clock::time_point m_frameStart;
+    bool m_started;
+    // Ring of the last frame times in milliseconds
+    std::vector<double> m_frameTimes;
+    int m_next;
+    int m_count;
+};
+
+#endif
@@ -0,0 +1,66 @@
+/** @file FrameUniforms.hpp
+ *  @brief Camera and light state shared by every program through uniform buffers.
+ *
+ *  Two std140 blocks, FrameData (shaders/frame.glsl) and LightData
+ *  (shaders/lighting.glsl), live in buffers bound to fixed binding
+ *  points. A program only has to be attached once; after that the state
+ *  is set here, and each block is uploaded at most once per call to
+ *  Upload, and only if something in it changed.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef FRAMEUNIFORMS_HPP
+#define FRAMEUNIFORMS_HPP
+
+#include <glad/glad.h>
+#include "glm/glm.hpp"
+
+#include "Shader.hpp"
+
+class FrameUniforms{
+public:
+    // Create both buffers and bind them to their binding points
+    FrameUniforms();
+    // Release both buffers
+    ~FrameUniforms();
+    // Point the blocks 'shader' declares at these buffers
+    void Attach(Shader& shader) const;
+    // Perspective projection, only rebuilt when one of its parameters changes
+    const glm::mat4& SetPerspective(float fovy, float aspect, float nearPlane, float farPlane);
+    // Any other projection, such as the far field's depth range
+    void SetProjection(const glm::mat4& projection);
+    void SetView(const glm::mat4& view, const glm::vec3& eye);
+    void SetLight(const glm::vec3& position, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular);
+    // Upload the blocks that changed since the last upload
+    void Upload();
+
+private:
+    static const GLuint FRAME_BINDING = 0;
+    static const GLuint LIGHT_BINDING = 1;
+
+    // std140 layouts, a vec3 takes the space of a vec4
+    struct FrameBlock{
+        glm::mat4 projection;
+        glm::mat4 view;
+        glm::vec4 viewPos;
+    };
+    struct LightBlock{
+        glm::vec4 position;
+        glm::vec4 ambient;
+        glm::vec4 diffuse;
+        glm::vec4 specular;
+    };
+
+    GLuint m_frameUBO;
+    GLuint m_lightUBO;
+    FrameBlock m_frame;
+    LightBlock m_light;
+    bool m_frameDirty;
+    bool m_lightDirty;
+
+    // Parameters (fovy, aspect, near, far) of the cached perspective
+    glm::vec4 m_perspectiveParameters;
+    glm::mat4 m_perspective;
+};
+
+#endif
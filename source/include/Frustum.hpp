@@ -0,0 +1,46 @@
+/** @file Frustum.hpp
+ *  @brief View frustum culling of axis aligned bounding boxes.
+ *
+ *  The six planes are taken from a combined projection and view matrix.
+ *  Boxes are kept as separate arrays of centers and half extents so four
+ *  of them can be tested against a plane at once with SIMD.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include <vector>
+
+#include "glm/glm.hpp"
+
+// Bounding boxes stored component by component
+struct BoxList{
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+
+    // Set the number of boxes, padded so every group of four is complete
+    void Resize(int count);
+    // Store box 'index' from its corners
+    void Set(int index, const glm::vec3& min, const glm::vec3& max);
+    int Size() const;
+
+private:
+    int m_count = 0;
+};
+
+class Frustum{
+public:
+    // Planes of the frustum of 'viewProjection' (projection * view)
+    Frustum(const glm::mat4& viewProjection);
+    // Is any part of the box inside the frustum
+    bool Intersects(const glm::vec3& min, const glm::vec3& max) const;
+    // Set visible[i] for every box in 'boxes', returns how many are visible
+    int Cull(const BoxList& boxes, std::vector<char>& visible) const;
+
+private:
+    // Plane i is dot(normal, p) + d >= 0 on the inside: (a, b, c, d)
+    glm::vec4 m_planes[6];
+};
+
+#endif
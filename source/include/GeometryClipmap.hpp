@@ -0,0 +1,82 @@
+/** @file GeometryClipmap.hpp
+ *  @brief Nested grids of terrain around the camera, backed by heightmaps.
+ *
+ *  Every level is a square grid twice as coarse as the one inside it,
+ *  centered on the camera. Each level samples its heights from its own
+ *  texture, which is addressed toroidally: as the camera moves only the
+ *  rows and columns that came into view are generated and written over
+ *  the ones that left, so the work per frame follows camera motion
+ *  rather than view distance.
+ *
+ *  Only the finest level is drawn as a whole grid. The others are drawn
+ *  as rings around the footprint of the level inside them. Centers snap
+ *  to every other vertex, so that footprint sits either on the center or
+ *  one cell off it along each axis. The four rings this gives are kept
+ *  as ranges of one index buffer.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef GEOMETRYCLIPMAP_HPP
+#define GEOMETRYCLIPMAP_HPP
+
+#include <vector>
+#include <functional>
+
+#include <glad/glad.h>
+#include "glm/glm.hpp"
+
+#include "Shader.hpp"
+
+class GeometryClipmap{
+public:
+    // Fills 'out' with width x height terrain heights, row by row, for
+    // the world positions (x + i * spacing, z + j * spacing)
+    typedef std::function<void(float x, float z, float spacing, int width, int height, float* out)> HeightFunction;
+
+    // 'levels' grids of 'size' texels per side (a power of two), the
+    // finest one 'spacing' world units between vertices
+    GeometryClipmap(int levels, int size, float spacing, HeightFunction heightFunction);
+    // Release the textures and the grid mesh
+    ~GeometryClipmap();
+    // Move every level to the camera, generating what came into view
+    void Update(const glm::vec3& eye);
+    // Throw away every height, e.g. after the terrain parameters changed
+    void Invalidate();
+    // Draw every level, the shader must be bound
+    void Render(Shader& shader) const;
+    // Distance up to which the coarsest level reaches
+    float GetViewDistance() const;
+
+private:
+    struct Level{
+        GLuint texture;
+        // Grid coordinates (in this level's spacing) of the center vertex
+        glm::ivec2 center;
+        // Grid coordinates of the first texel held by the texture
+        glm::ivec2 origin;
+        bool valid;
+    };
+
+    // Generate and upload a block of grid coordinates, wrapping it
+    // around the edges of the texture
+    void UpdateRegion(int level, int x, int y, int width, int height);
+    float GetSpacing(int level) const;
+
+    int m_size;
+    // Vertices reach this many cells either side of a level's center
+    int m_halfCells;
+    float m_spacing;
+    HeightFunction m_heightFunction;
+    std::vector<Level> m_levels;
+    std::vector<float> m_scratch;
+
+    GLuint m_VAO;
+    GLuint m_VBO;
+    GLuint m_EBO;
+    GLsizei m_indexCount;
+    // Rings by where the finer footprint sits, x + 2 * y cells off center
+    GLsizei m_ringFirst[4];
+    GLsizei m_ringCount;
+};
+
+#endif
@@ -0,0 +1,35 @@
+/** @file HeightCodec.hpp
+ *  @brief Compresses chunk heightfields for storage.
+ *
+ *  Heights are rounded to multiples of a step shared by every chunk and
+ *  stored as 16 bit offsets from the chunk's lowest one, so a height two
+ *  chunks both hold always decodes to the same value. They are predicted
+ *  from their left, upper and upper-left neighbours, and the
+ *  residuals are Rice coded. Decoding rebuilds whole rows at a time with
+ *  SIMD where it is available.
+ *
+ *  A grid whose range does not fit in 16 bits of the step is stored as
+ *  raw floats instead, still rounded to the step, so the step never
+ *  changes from one chunk to the next.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef HEIGHTCODEC_HPP
+#define HEIGHTCODEC_HPP
+
+#include <vector>
+#include <cstddef>
+
+class HeightCodec{
+public:
+    // Compress a width x height grid of heights rounded to multiples of
+    // 'step', a power of two. Grids whose range does not fit in 16 bits
+    // of it are stored uncompressed.
+    static std::vector<char> Encode(const float* heights, int width, int height, float step);
+    // Decompress into 'out', returns false if the data is not a valid stream
+    static bool Decode(const char* data, size_t size, std::vector<float>& out);
+    // Reads the grid size from the stream header without decoding it
+    static bool GetSize(const char* data, size_t size, int& width, int& height);
+};
+
+#endif
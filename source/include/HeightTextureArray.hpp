@@ -0,0 +1,51 @@
+/** @file HeightTextureArray.hpp
+ *  @brief Chunk heights kept on the GPU, one texture array layer per chunk.
+ *
+ *  Modes that build their vertices on the GPU only need a chunk's
+ *  heights, so a chunk upload is a single layer instead of full vertex
+ *  buffers. Heights are stored as 16 bit fractions of a range shared by
+ *  every layer, a 129 x 129 chunk is about 33 KB. Shaders get the
+ *  height back as u_HeightMin + sample * u_HeightRange.
+ *
+ *  Vertices sit on texel centers, and the texture filters linearly for
+ *  lookups between them.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef HEIGHTTEXTUREARRAY_HPP
+#define HEIGHTTEXTUREARRAY_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include <glad/glad.h>
+
+class HeightTextureArray{
+public:
+    // Room for 'layers' layers of 'size' x 'size' heights
+    HeightTextureArray(int size, int layers);
+    // Release the texture
+    ~HeightTextureArray();
+    // Heights the layers cover, those outside are clamped. Layers
+    // uploaded before a change of range have to be uploaded again.
+    void SetRange(float minHeight, float maxHeight);
+    // Copy 'size' x 'size' heights, row by row, into a layer
+    void Upload(int layer, const float* heights);
+    // Bind the texture array to 'textureUnit'
+    void Bind(GLenum textureUnit) const;
+    // Heights per side of a layer
+    int GetSize() const;
+    // Height of a sample of 0, and how much higher one of 1 is
+    float GetMinHeight() const;
+    float GetHeightRange() const;
+
+private:
+    int m_size;
+    GLuint m_texture;
+    float m_minHeight;
+    float m_heightRange;
+    // Quantized heights of the layer being uploaded
+    std::vector<uint16_t> m_samples;
+};
+
+#endif
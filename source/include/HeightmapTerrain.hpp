@@ -0,0 +1,50 @@
+/** @file HeightmapTerrain.hpp
+ *  @brief Chunks drawn from one shared grid displaced by their heightmaps.
+ *
+ *  The x and z of every chunk vertex are the same, so a single flat grid
+ *  of (chunkCells + 1)^2 vertices is shared by all of them. The vertex
+ *  shader pulls each vertex's height from the chunk's layer of a
+ *  HeightTextureArray and builds its normal and biome color from there.
+ *
+ *  The grid is instanced once per visible chunk, each instance carrying
+ *  its chunk's origin and layer, so all of them go out in a single draw.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef HEIGHTMAPTERRAIN_HPP
+#define HEIGHTMAPTERRAIN_HPP
+
+#include <vector>
+
+#include <glad/glad.h>
+#include "glm/glm.hpp"
+
+#include "Shader.hpp"
+#include "HeightTextureArray.hpp"
+
+class HeightmapTerrain{
+public:
+    // Instance attribute, matching the shader location
+    static const int CHUNK = 1;
+
+    // A grid of 'chunkCells' x 'chunkCells' cells
+    HeightmapTerrain(int chunkCells);
+    // Release the grid and the instance buffer
+    ~HeightmapTerrain();
+    // Bind the grid and the chunk heights to the bound shader
+    void Bind(Shader& shader, const HeightTextureArray& heights) const;
+    // Draw one instance per chunk, each the chunk's origin (xyz) and its
+    // layer (w)
+    void Draw(const std::vector<glm::vec4>& chunks) const;
+
+private:
+    int m_chunkCells;
+
+    GLuint m_VAO;
+    GLuint m_VBO;
+    GLuint m_EBO;
+    GLuint m_instanceVBO;
+    GLsizei m_indexCount;
+};
+
+#endif
@@ -0,0 +1,47 @@
+/** @file HorizonCuller.hpp
+ *  @brief Occlusion culling of terrain against the horizon seen so far.
+ *
+ *  The horizon is kept as the highest elevation (the tangent of the angle
+ *  above the eye) in each of a number of azimuth bins around the camera.
+ *  Terrain is processed front to back: every box is first tested against
+ *  the horizon, and if it is visible the solid parts of it are added to
+ *  the horizon, hiding whatever lies below them further away.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef HORIZONCULLER_HPP
+#define HORIZONCULLER_HPP
+
+#include <vector>
+
+#include "glm/glm.hpp"
+
+class HorizonCuller{
+public:
+    // Split the full circle around the camera into 'bins' directions
+    HorizonCuller(int bins);
+    // Clear the horizon for a new frame seen from 'eye'
+    void Begin(const glm::vec3& eye);
+    // Is the whole box below the horizon
+    bool IsOccluded(const glm::vec3& min, const glm::vec3& max) const;
+    // Raise the horizon with a box that is solid all the way up to max.y
+    void AddOccluder(const glm::vec3& min, const glm::vec3& max);
+
+private:
+    // The range of bins a box covers, and its nearest and furthest
+    // horizontal distance. Returns false if the eye is above the box
+    // (inside its footprint), where it covers every direction.
+    bool Project(const glm::vec3& min, const glm::vec3& max, float& firstBin, float& lastBin,
+                 float& nearest, float& furthest) const;
+    // Is 'elevation' above the horizon anywhere in bins [first, last)
+    bool AboveHorizon(int first, int last, float elevation) const;
+    // Raise the horizon to 'elevation' in bins [first, last)
+    void RaiseHorizon(int first, int last, float elevation);
+
+    int m_bins;
+    glm::vec3 m_eye;
+    // Highest elevation in every bin
+    std::vector<float> m_horizon;
+};
+
+#endif
@@ -0,0 +1,74 @@
+/** @file OcclusionRasterizer.hpp
+ *  @brief Software depth rasterizer for occlusion culling.
+ *
+ *  Coarse occluder triangles are drawn on the CPU into a small depth
+ *  buffer, split in horizontal bands that worker threads fill in
+ *  parallel. A pyramid of the furthest depth in each 2x2 block is then
+ *  built over it, so a bounding box can be tested against a handful of
+ *  texels whatever its size on screen.
+ *
+ *  Occluders write the furthest depth inside each pixel, and every pixel
+ *  then takes the furthest depth of its neighbours, so the partly covered
+ *  pixels along an occluder's outline never hide anything visible.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef OCCLUSIONRASTERIZER_HPP
+#define OCCLUSIONRASTERIZER_HPP
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "glm/glm.hpp"
+
+class OcclusionRasterizer{
+public:
+    // A 'width' x 'height' depth buffer filled by 'threads' threads
+    OcclusionRasterizer(int width, int height, int threads);
+    // Stop the worker threads
+    ~OcclusionRasterizer();
+    // Start a new frame seen through 'viewProjection'
+    void Begin(const glm::mat4& viewProjection);
+    // Queue triangles in world space, three indices per triangle
+    void AddOccluder(const std::vector<glm::vec3>& vertices, const std::vector<int>& indices);
+    // Draw the queued triangles and build the depth pyramid
+    void Rasterize();
+    // Is the box hidden behind what was rasterized
+    bool IsOccluded(const glm::vec3& min, const glm::vec3& max) const;
+
+private:
+    // Triangle in screen space, x and y in pixels and z in [0, 1]
+    struct Triangle{
+        glm::vec3 v[3];
+    };
+
+    // Draw every queued triangle into rows [firstRow, lastRow)
+    void RasterizeBand(int firstRow, int lastRow);
+    void RasterizeTriangle(const Triangle& triangle, int firstRow, int lastRow);
+    void BuildPyramid();
+    void WorkerLoop(int band);
+
+    int m_width;
+    int m_height;
+    glm::mat4 m_viewProjection;
+    std::vector<Triangle> m_triangles;
+    // Level 0 is the depth buffer, each level after it is half the size
+    std::vector<std::vector<float>> m_levels;
+    std::vector<glm::ivec2> m_levelSizes;
+    // Scratch buffer for the neighbour pass
+    std::vector<float> m_dilated;
+
+    // Worker threads, each fills its own band of rows
+    int m_bands;
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    int m_frame;
+    int m_pending;
+    bool m_stop;
+};
+
+#endif
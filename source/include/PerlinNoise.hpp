@@ -3,16 +3,15 @@
 #include <algorithm>
 #include <random>
 
-std::vector<int> createRandomPermutation() {
+std::vector<int> createRandomPermutation(unsigned int seed) {
     // Create a vector with integers from 0 to 255
     std::vector<int> permutation(256);
     for (int i = 0; i < 256; ++i) {
         permutation[i] = i;
     }
 
-    // Use random_device for a random seed
-    std::random_device rd;
-    std::mt19937 g(rd());
+    // The same seed always gives the same world
+    std::mt19937 g(seed);
 
     // Shuffle the permutation vector
     std::shuffle(permutation.begin(), permutation.end(), g);
@@ -23,10 +22,10 @@ std::vector<int> createRandomPermutation() {
     return permutation;
 }
 
-std::vector<int> getPermutationVector () {
+std::vector<int> getPermutationVector (unsigned int seed) {
     std::vector<int> p;
 
-    std::vector<int> permutation = createRandomPermutation();
+    std::vector<int> permutation = createRandomPermutation(seed);
 
     p.insert(p.end(), permutation.begin(), permutation.end());
     p.insert(p.end(), permutation.begin(), permutation.end());
@@ -0,0 +1,47 @@
+/** @file RtinMesh.hpp
+ *  @brief Error bounded adaptive triangulation of a chunk heightfield.
+ *
+ *  A right-triangulated irregular network over a (2^k + 1)^2 grid: every
+ *  triangle is split at the middle of its longest edge, recursively, and
+ *  a split is only made where skipping it would leave a height error
+ *  above the threshold. The result indexes the chunk's full resolution
+ *  vertices, so it can be drawn from the same arena slot.
+ *
+ *  Border vertices are always kept, so neighbouring chunks meet without
+ *  cracks whatever their triangulations are.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef RTINMESH_HPP
+#define RTINMESH_HPP
+
+#include <vector>
+#include <cstdint>
+
+class RtinMesh{
+public:
+    // Prepare the triangle hierarchy of a 'gridSize' x 'gridSize' grid
+    RtinMesh(int gridSize);
+    // Error of every vertex: the largest height error left if it is not
+    // used. Heights are read 'stride' floats apart, row by row.
+    std::vector<float> ComputeErrors(const float* heights, int stride) const;
+    // Indices of the triangles needed to stay within 'maxError'
+    std::vector<int> Triangulate(const std::vector<float>& errors, float maxError) const;
+
+private:
+    // Longest leg kept, in grid steps. Huge triangles reaching behind the
+    // camera are clipped apart slightly differently on either side of a
+    // shared edge, which leaves pixel gaps.
+    static const int MAX_LEG = 32;
+
+    void AddTriangle(const std::vector<float>& errors, float maxError, std::vector<int>& indices,
+                     int ax, int ay, int bx, int by, int cx, int cy) const;
+
+    int m_gridSize;
+    int m_numTriangles;
+    int m_numParentTriangles;
+    // Both ends of the longest edge (ax, ay, bx, by) of every triangle
+    std::vector<uint16_t> m_coords;
+};
+
+#endif
@@ -1,7 +1,14 @@
 /** @file Shader.hpp
  *  @brief Manages the loading, compiling, and linking of vertex and fragment shaders.
  *  
- *  Additionally has functions for setting various uniforms.
+ *  Additionally has functions for setting various uniforms. Every active
+ *  uniform is looked up once after linking; hot paths should fetch a
+ *  typed Uniform handle up front and set it without any name lookup.
+ *
+ *  Linked programs can be kept on disk with SetBinaryCache. A program is
+ *  stored under a hash of its sources and of the driver that built it,
+ *  so an edited shader or an updated driver simply misses the cache and
+ *  is compiled again.
  *
  *  @author Mike
  *  @bug No known bugs.
@@ -10,6 +17,7 @@
 #define SHADER_HPP
 
 #include <string>
+#include <unordered_map>
 
 #if defined(LINUX) || defined(MINGW)
     #include <SDL2/SDL.h>
@@ -18,13 +26,29 @@
 #endif
 
 #include <glad/glad.h>
+#include "glm/glm.hpp"
 
 class Shader{
 public:
+    // A uniform location resolved up front. Setting it only touches the
+    // currently bound program, and a handle to a missing uniform does nothing.
+    template<typename T>
+    class Uniform{
+    public:
+        Uniform(GLint location = -1) : m_location(location) {}
+        void Set(const T& value) const;
+        bool IsValid() const { return m_location >= 0; }
+    private:
+        GLint m_location;
+    };
+
     // Shader constructor
     Shader();
     // Shader Destructor
     ~Shader();
+    // Keep linked programs in 'directory' and load them back from there
+    // instead of compiling, an empty directory turns the cache off
+    static void SetBinaryCache(const std::string& directory);
     // Use this shader in our pipeline.
     void Bind() const;
     // Remove shader from our pipeline
@@ -33,15 +57,37 @@ public:
     std::string LoadShader(const std::string& fname);
     // Create a Shader from a loaded vertex and fragment shader
     void CreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource);
+    // Create a Shader with tessellation control and evaluation stages as well
+    void CreateShader(const std::string& vertexShaderSource, const std::string& tessControlShaderSource,
+                      const std::string& tessEvaluationShaderSource, const std::string& fragmentShaderSource);
     // return the shader id
     GLuint GetID() const;
+    // Read the uniform block 'name' from buffer binding point 'binding',
+    // blocks the program does not use are ignored
+    void BindUniformBlock(const GLchar* name, GLuint binding);
+    // Resolve a uniform once, reporting it if it is missing or of another type
+    template<typename T>
+    Uniform<T> GetUniform(const GLchar* name);
     // Set our uniforms for our shader.
     void SetUniformMatrix4fv(const GLchar* name, const GLfloat* value);
 	void SetUniform3f(const GLchar* name, float v0, float v1, float v2);
     void SetUniform1i(const GLchar* name, int value);
     void SetUniform1f(const GLchar* name, float value);
+    void SetUniform2f(const GLchar* name, float v0, float v1);
+    void SetUniform4f(const GLchar* name, float v0, float v1, float v2, float v3);
+    void SetUniform1iv(const GLchar* name, int count, const int* values);
+    void SetUniform1fv(const GLchar* name, int count, const float* values);
+    void SetUniform3fv(const GLchar* name, int count, const float* values);
 
 private:
+    // Build the program from 'count' shader files of the given stages,
+    // from the binary cache when it holds them
+    void CreateProgram(const std::string* files, const GLenum* types, int count);
+    // Load the program from a cached binary, false if it is missing or
+    // the driver does not take it anymore
+    bool LoadBinary(const std::string& path);
+    // Store the linked program's binary for the next run
+    void SaveBinary(const std::string& path);
     // Compiles loaded shaders
     unsigned int CompileShader(unsigned int type, const std::string& source);
     // Makes sure shaders 'linked' successfully
@@ -51,8 +97,37 @@ private:
     void PrintShaderLog( GLuint shader );
     // Logs an error message 
     void Log(const char* system, const char* message);
+    // Record the location and type of every active uniform
+    void ReflectUniforms();
+    // Location of a uniform, reports unknown names the first time only
+    GLint FindUniform(const std::string& name);
+    // Location of a uniform whose type must be 'type'
+    GLint FindUniform(const std::string& name, GLenum type);
+
+    struct UniformInfo{
+        GLint location;
+        GLenum type;
+    };
     // The unique shaderID
     GLuint m_shaderID;
+    // Active uniforms by name, arrays are also found without "[0]"
+    std::unordered_map<std::string, UniformInfo> m_uniforms;
+    // Where program binaries are kept, empty when they are not
+    static std::string s_binaryCache;
 };
 
+// The types handles can be made for, and the GL type each one matches
+template<> void Shader::Uniform<int>::Set(const int& value) const;
+template<> void Shader::Uniform<float>::Set(const float& value) const;
+template<> void Shader::Uniform<glm::vec2>::Set(const glm::vec2& value) const;
+template<> void Shader::Uniform<glm::vec3>::Set(const glm::vec3& value) const;
+template<> void Shader::Uniform<glm::vec4>::Set(const glm::vec4& value) const;
+template<> void Shader::Uniform<glm::mat4>::Set(const glm::mat4& value) const;
+template<> Shader::Uniform<int> Shader::GetUniform<int>(const GLchar* name);
+template<> Shader::Uniform<float> Shader::GetUniform<float>(const GLchar* name);
+template<> Shader::Uniform<glm::vec2> Shader::GetUniform<glm::vec2>(const GLchar* name);
+template<> Shader::Uniform<glm::vec3> Shader::GetUniform<glm::vec3>(const GLchar* name);
+template<> Shader::Uniform<glm::vec4> Shader::GetUniform<glm::vec4>(const GLchar* name);
+template<> Shader::Uniform<glm::mat4> Shader::GetUniform<glm::mat4>(const GLchar* name);
+
 #endif
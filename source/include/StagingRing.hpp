@@ -0,0 +1,45 @@
+/** @file StagingRing.hpp
+ *  @brief Ring of mapped staging regions for streaming data to the GPU.
+ *
+ *  Data is written straight into a region of one staging buffer, mapped
+ *  unsynchronized with its old contents invalidated, and then copied on
+ *  the GPU into its destination buffer. A fence placed after each copy
+ *  tells when the region may be mapped again, so the CPU only ever waits
+ *  when it has gone a whole ring ahead of the GPU.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef STAGINGRING_HPP
+#define STAGINGRING_HPP
+
+#include <vector>
+
+#include <glad/glad.h>
+
+class StagingRing{
+public:
+    // 'regions' regions of 'regionSize' bytes each
+    StagingRing(GLsizeiptr regionSize, int regions);
+    // Release the staging buffer and any fences left
+    ~StagingRing();
+    // Map the next region for writing 'size' bytes, waiting for the GPU to
+    // be done with it first. Returns nullptr if 'size' does not fit.
+    void* Map(GLsizeiptr size);
+    // Unmap the region and copy what was written to 'offset' in 'buffer'.
+    // Returns false, without copying, if the last Map failed or the region
+    // was lost while mapped, the data then has to be sent another way.
+    bool Unmap(GLuint buffer, GLintptr offset);
+    // Size of a single region
+    GLsizeiptr GetRegionSize() const;
+
+private:
+    GLuint m_buffer;
+    GLsizeiptr m_regionSize;
+    // Region currently mapped (or mapped next) and the bytes mapped in it
+    int m_current;
+    GLsizeiptr m_mappedSize;
+    // Fence after the last copy out of every region, 0 once passed
+    std::vector<GLsync> m_fences;
+};
+
+#endif
@@ -0,0 +1,54 @@
+/** @file TessellatedTerrain.hpp
+ *  @brief Chunks drawn as coarse patches refined by hardware tessellation.
+ *
+ *  Every chunk is drawn with the same small grid of quad patches. The
+ *  tessellation control shader splits each patch edge by its length on
+ *  screen, and the evaluation shader displaces the new vertices from the
+ *  chunk's layer of a HeightTextureArray. Only heights are uploaded per
+ *  chunk, the vertices, normals and colors are all built on the GPU.
+ *
+ *  Edge factors only depend on the edge's two end points, so patches
+ *  (and chunks) sharing an edge split it the same way and never crack.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef TESSELLATEDTERRAIN_HPP
+#define TESSELLATEDTERRAIN_HPP
+
+#include <glad/glad.h>
+#include "glm/glm.hpp"
+
+#include "Shader.hpp"
+#include "HeightTextureArray.hpp"
+
+class TessellatedTerrain{
+public:
+    // Chunks of 'chunkCells' cells per side split into patches of
+    // 'patchCells' cells
+    TessellatedTerrain(int chunkCells, int patchCells);
+    // Release the patch grid
+    ~TessellatedTerrain();
+    // Bind the patch grid and the chunk heights to the bound shader
+    void Bind(Shader& shader, const HeightTextureArray& heights);
+    // Draw one chunk whose first vertex is at 'origin' with the shader
+    // given to Bind
+    void Draw(int layer, const glm::vec3& origin) const;
+    // Number of vertices in the patch grid shared by every chunk
+    int GetPatchVertexCount() const;
+
+private:
+    int m_chunkCells;
+    int m_patchCells;
+    int m_patchVertexCount;
+
+    GLuint m_VAO;
+    GLuint m_VBO;
+    GLuint m_EBO;
+    GLsizei m_indexCount;
+
+    // Per chunk uniforms of the shader given to Bind
+    Shader::Uniform<glm::vec3> m_chunkOrigin;
+    Shader::Uniform<float> m_layer;
+};
+
+#endif
@@ -0,0 +1,38 @@
+/** @file WaterPlane.hpp
+ *  @brief Flat water surface that follows the camera.
+ *
+ *  Terrain is no longer clamped to the water level, so everything below
+ *  it is covered by this one coarse grid instead. The grid is centered
+ *  under the camera every frame, moving in whole cells so its vertices
+ *  do not swim.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef WATERPLANE_HPP
+#define WATERPLANE_HPP
+
+#include <glad/glad.h>
+#include "glm/glm.hpp"
+
+#include "Shader.hpp"
+
+class WaterPlane{
+public:
+    // 'gridSize' x 'gridSize' cells covering 'size' world units, drawn in 'color'
+    WaterPlane(int gridSize, float size, glm::vec3 color);
+    // Release the grid mesh
+    ~WaterPlane();
+    // Draw the surface at 'height' under 'eye', with the terrain shader bound
+    void Render(Shader& shader, const glm::vec3& eye, float height) const;
+
+private:
+    float m_cellSize;
+    float m_size;
+
+    GLuint m_VAO;
+    GLuint m_VBO;
+    GLuint m_EBO;
+    GLsizei m_indexCount;
+};
+
+#endif
@@ -0,0 +1,50 @@
+/** @file WorkerPool.hpp
+ *  @brief A fixed set of worker threads running queued tasks.
+ *
+ *  Tasks are queued with Submit and run in any order on the first free
+ *  worker, Wait returns once every task queued so far is done. A loop
+ *  can be split over the workers with ParallelFor, which the calling
+ *  thread helps with, so it also completes from inside a task even if
+ *  every other worker is busy.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef WORKERPOOL_HPP
+#define WORKERPOOL_HPP
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class WorkerPool{
+public:
+    // A pool of 'threads' worker threads
+    WorkerPool(int threads);
+    // Finish the queued tasks and stop the workers
+    ~WorkerPool();
+    // Queue a task for the workers
+    void Submit(std::function<void()> task);
+    // Wait until every submitted task has finished
+    void Wait();
+    // Run 'job' over [0, count) in ranges of 'grain' indices, on the
+    // workers and the calling thread. Returns once all ranges are done.
+    void ParallelFor(int count, int grain, const std::function<void(int, int)>& job);
+    int GetThreads() const;
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::deque<std::function<void()>> m_tasks;
+    // Tasks queued or running
+    int m_pending;
+    bool m_stop;
+};
+
+#endif
@@ -0,0 +1,37 @@
+#version 410 core
+#include "frame.glsl"
+#include "terrain.glsl"
+
+// Integer coordinates on the shared grid mesh
+layout(location=0) in vec2 gridPosition;
+
+// The quadtree node being drawn
+uniform vec2 u_NodeOrigin;
+uniform float u_NodeSize;
+// Cells across the node, half the grid for a quarter node
+uniform float u_GridSize;
+// Distances over which vertices morph into the parent level's grid
+uniform vec2 u_MorphRange;
+
+out vec3 v_vertexColors;
+out vec3 v_vertexNormals;
+out vec3 FragPos;
+
+void main() {
+    float cellSize = u_NodeSize / u_GridSize;
+    vec2 world = u_NodeOrigin + gridPosition * cellSize;
+
+    // Odd vertices slide onto their even neighbour as they approach the
+    // end of this level's range, so the mesh matches the next level there
+    float dist = distance(u_ViewPos, vec3(world.x, terrainHeight(world), world.y));
+    float morph = clamp((dist - u_MorphRange.x) / (u_MorphRange.y - u_MorphRange.x), 0.0, 1.0);
+    vec2 odd = fract(gridPosition * 0.5) * 2.0;
+    world -= odd * cellSize * morph;
+
+    float height = terrainHeight(world);
+    v_vertexColors = terrainColor(height);
+    v_vertexNormals = terrainNormal(world, height, cellSize);
+    FragPos = vec3(world.x, height, world.y);
+
+    gl_Position = u_Projection * u_ViewMatrix * vec4(FragPos, 1.0f);
+}
@@ -0,0 +1,12 @@
+#version 410 core
+#include "lighting.glsl"
+
+in vec3 v_vertexColors;
+in vec3 v_vertexNormals;
+in vec3 FragPos;
+
+out vec4 FragColor;
+
+void main() {
+    FragColor = vec4(applyLighting(v_vertexColors, v_vertexNormals, FragPos), 1.0f);
+}
@@ -0,0 +1,46 @@
+#version 410 core
+#include "frame.glsl"
+#include "terrain.glsl"
+
+// Cell offset from the center of the level
+layout(location=0) in vec2 gridPosition;
+
+// Heights of the level, addressed toroidally by grid coordinates
+uniform sampler2D u_Heightmap;
+uniform float u_TextureSize;
+// The level being drawn
+uniform float u_Spacing;
+uniform vec2 u_LevelCenter;
+uniform float u_HalfCells;
+// Width of the band at the outer edge that morphs into the coarser level
+uniform float u_MorphCells;
+
+out vec3 v_vertexColors;
+out vec3 v_vertexNormals;
+out vec3 FragPos;
+
+float heightAt(ivec2 texel) {
+    return texelFetch(u_Heightmap, texel & ivec2(int(u_TextureSize) - 1), 0).r;
+}
+
+void main() {
+    vec2 grid = u_LevelCenter + gridPosition;
+    ivec2 texel = ivec2(grid);
+
+    // Towards the outer edge odd vertices slide onto their even neighbour,
+    // so the edge matches the coarser level around it exactly
+    float edgeDistance = u_HalfCells - max(abs(gridPosition.x), abs(gridPosition.y));
+    float morph = clamp(1.0 - edgeDistance / u_MorphCells, 0.0, 1.0);
+    vec2 odd = fract(grid * 0.5) * 2.0;
+    vec2 morphed = vec2(texel & ivec2(int(u_TextureSize) - 1)) - odd * morph;
+    float height = texture(u_Heightmap, (morphed + 0.5) / u_TextureSize).r;
+
+    float hx = heightAt(texel - ivec2(1, 0)) - heightAt(texel + ivec2(1, 0));
+    float hz = heightAt(texel - ivec2(0, 1)) - heightAt(texel + ivec2(0, 1));
+    v_vertexNormals = normalize(vec3(hx, 2.0 * u_Spacing, hz));
+    v_vertexColors = terrainColor(height);
+
+    vec2 world = (grid - odd * morph) * u_Spacing;
+    FragPos = vec3(world.x, height, world.y);
+    gl_Position = u_Projection * u_ViewMatrix * vec4(FragPos, 1.0f);
+}
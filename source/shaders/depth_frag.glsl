@@ -0,0 +1,5 @@
+#version 410 core
+
+// Depth pre-pass, the depth test and writes do all the work
+void main() {
+}
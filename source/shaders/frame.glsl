@@ -0,0 +1,12 @@
+// Camera state of the current frame, shared by every program
+// (FrameUniforms keeps it up to date)
+#ifndef FRAME_GLSL
+#define FRAME_GLSL
+
+layout(std140) uniform FrameData {
+    mat4 u_Projection;
+    mat4 u_ViewMatrix;
+    vec3 u_ViewPos;
+};
+
+#endif
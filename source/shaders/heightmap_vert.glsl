@@ -0,0 +1,39 @@
+#version 410 core
+#include "frame.glsl"
+#include "terrain.glsl"
+
+// Point on the grid shared by every chunk, in cells
+layout(location=0) in vec2 gridPosition;
+// Origin of the chunk this instance draws (xyz) and its height layer (w)
+layout(location=1) in vec4 chunk;
+
+uniform sampler2DArray u_Heights;
+// Heights are stored as fractions of this range
+uniform float u_HeightMin;
+uniform float u_HeightRange;
+uniform int u_ChunkCells;
+
+out vec3 v_vertexColors;
+out vec3 v_vertexNormals;
+out vec3 FragPos;
+
+// Height of a grid point of the chunk, clamped to its border
+float gridHeight(ivec2 point, int layer) {
+    point = clamp(point, ivec2(0), ivec2(u_ChunkCells));
+    return u_HeightMin + texelFetch(u_Heights, ivec3(point, layer), 0).r * u_HeightRange;
+}
+
+void main() {
+    ivec2 point = ivec2(gridPosition);
+    int layer = int(chunk.w);
+
+    float height = gridHeight(point, layer);
+    float hx = gridHeight(point + ivec2(1, 0), layer) - gridHeight(point - ivec2(1, 0), layer);
+    float hz = gridHeight(point + ivec2(0, 1), layer) - gridHeight(point - ivec2(0, 1), layer);
+
+    v_vertexColors = terrainColor(height);
+    v_vertexNormals = normalize(vec3(-hx, 2.0, -hz));
+    FragPos = chunk.xyz + vec3(gridPosition.x, height, gridPosition.y);
+
+    gl_Position = u_Projection * u_ViewMatrix * vec4(FragPos, 1.0f);
+}
@@ -0,0 +1,34 @@
+// Lighting shared by the terrain fragment shaders
+#include "frame.glsl"
+
+struct Light {
+    vec3 lightPos;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+// Set once for every program by FrameUniforms
+layout(std140) uniform LightData {
+    Light u_Light;
+};
+
+vec3 applyLighting(vec3 color, vec3 normal, vec3 fragPos) {
+    // Ambient
+    vec3 ambient = u_Light.ambient;
+    
+    // Diffuse
+    vec3 norm = normalize(normal);
+    vec3 lightDir = normalize(u_Light.lightPos - fragPos);
+    float diffImpact = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diffImpact * u_Light.diffuse;
+
+    // Specular
+    vec3 viewDir = normalize(u_ViewPos - fragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 16);
+    vec3 specular = spec * u_Light.specular;
+    
+    vec3 lighting = ambient + diffuse + specular;
+    return color * lighting;
+}
@@ -0,0 +1,85 @@
+// Terrain height and color computed on the GPU.
+// Matches generateNoiseMap, generateVertices and generateBiome in main.cpp.
+
+uniform int u_Perm[256];
+uniform int u_Octaves;
+uniform float u_NoiseScale;
+uniform float u_Persistence;
+uniform float u_Lacunarity;
+uniform float u_MeshHeight;
+uniform float u_WaterHeight;
+// Moves world positions into noise space (half a chunk)
+uniform vec2 u_NoiseOffset;
+
+uniform float u_BiomeHeights[8];
+uniform vec3 u_BiomeColors[8];
+
+int perm(int i) {
+    return u_Perm[i & 255];
+}
+
+float fade(float t) {
+    return t * t * t * (t * (t * 6.0 - 15.0) + 10.0);
+}
+
+// The CPU noise always samples z = 0, so only x and y are left
+float grad(int hash, float x, float y) {
+    int h = hash & 15;
+    float u = h < 8 ? x : y;
+    float v = h < 4 ? y : (h == 12 || h == 14) ? x : 0.0;
+    return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
+}
+
+float perlinNoise(vec2 p) {
+    int X = int(floor(p.x)) & 255;
+    int Y = int(floor(p.y)) & 255;
+    p -= floor(p);
+    float u = fade(p.x);
+    float v = fade(p.y);
+    int A = perm(X) + Y, AA = perm(A), AB = perm(A + 1);
+    int B = perm(X + 1) + Y, BA = perm(B), BB = perm(B + 1);
+
+    return mix(mix(grad(perm(AA), p.x, p.y),
+                   grad(perm(BA), p.x - 1.0, p.y), u),
+               mix(grad(perm(AB), p.x, p.y - 1.0),
+                   grad(perm(BB), p.x - 1.0, p.y - 1.0), u), v);
+}
+
+// Normalized fractal noise at a world position
+float terrainNoise(vec2 world) {
+    vec2 pos = world + u_NoiseOffset;
+    float amp = 1.0;
+    float freq = 1.0;
+    float noiseHeight = 0.0;
+    float maxPossibleHeight = 0.0;
+
+    for (int i = 0; i < u_Octaves; i++) {
+        noiseHeight += perlinNoise(pos / u_NoiseScale * freq) * amp;
+        maxPossibleHeight += amp;
+        amp *= u_Persistence;
+        freq *= u_Lacunarity;
+    }
+    return (noiseHeight + 1.0) / maxPossibleHeight;
+}
+
+float terrainHeight(vec2 world) {
+    float noise = terrainNoise(world) * 1.1;
+    float easedNoise = noise * noise * noise;
+    return max(easedNoise * u_MeshHeight, u_WaterHeight * 0.5 * u_MeshHeight);
+}
+
+vec3 terrainColor(float height) {
+    for (int i = 0; i < 8; i++) {
+        if (height <= u_BiomeHeights[i] * u_MeshHeight) {
+            return u_BiomeColors[i];
+        }
+    }
+    return u_BiomeColors[7];
+}
+
+// Normal from the slope between 'world' and its neighbours 'step' away
+vec3 terrainNormal(vec2 world, float height, float step) {
+    float hx = terrainHeight(world + vec2(step, 0.0));
+    float hz = terrainHeight(world + vec2(0.0, step));
+    return normalize(vec3(height - hx, step, height - hz));
+}
@@ -0,0 +1,39 @@
+#version 410 core
+#include "frame.glsl"
+#include "tess_heights.glsl"
+
+layout(vertices = 4) out;
+
+// Pixels per world unit at a distance of one unit
+uniform float u_ProjectionScale;
+// Length on screen each tessellated segment should have
+uniform float u_PixelsPerSegment;
+uniform float u_MaxTessLevel;
+
+in vec2 tc_gridPosition[];
+out vec2 te_gridPosition[];
+
+// Segments for the edge between two corners, from its size on screen.
+// It only depends on the two corners, so both patches sharing an edge
+// agree on it.
+float edgeLevel(vec2 a, vec2 b) {
+    vec3 pa = chunkPosition(a);
+    vec3 pb = chunkPosition(b);
+    float dist = max(distance(u_ViewPos, (pa + pb) * 0.5), 1.0);
+    float pixels = distance(pa, pb) * u_ProjectionScale / dist;
+    return clamp(pixels / u_PixelsPerSegment, 1.0, u_MaxTessLevel);
+}
+
+void main() {
+    te_gridPosition[gl_InvocationID] = tc_gridPosition[gl_InvocationID];
+
+    if (gl_InvocationID == 0) {
+        // Outer levels are the edges u = 0, v = 0, u = 1 and v = 1
+        gl_TessLevelOuter[0] = edgeLevel(tc_gridPosition[3], tc_gridPosition[0]);
+        gl_TessLevelOuter[1] = edgeLevel(tc_gridPosition[0], tc_gridPosition[1]);
+        gl_TessLevelOuter[2] = edgeLevel(tc_gridPosition[1], tc_gridPosition[2]);
+        gl_TessLevelOuter[3] = edgeLevel(tc_gridPosition[2], tc_gridPosition[3]);
+        gl_TessLevelInner[0] = max(gl_TessLevelOuter[1], gl_TessLevelOuter[3]);
+        gl_TessLevelInner[1] = max(gl_TessLevelOuter[0], gl_TessLevelOuter[2]);
+    }
+}
@@ -0,0 +1,28 @@
+#version 410 core
+#include "frame.glsl"
+#include "terrain.glsl"
+#include "tess_heights.glsl"
+
+layout(quads, fractional_even_spacing, ccw) in;
+
+in vec2 te_gridPosition[];
+
+out vec3 v_vertexColors;
+out vec3 v_vertexNormals;
+out vec3 FragPos;
+
+void main() {
+    vec2 bottom = mix(te_gridPosition[0], te_gridPosition[1], gl_TessCoord.x);
+    vec2 top = mix(te_gridPosition[3], te_gridPosition[2], gl_TessCoord.x);
+    vec2 gridPosition = mix(bottom, top, gl_TessCoord.y);
+
+    float height = chunkHeight(gridPosition);
+    float hx = chunkHeight(gridPosition + vec2(1.0, 0.0)) - chunkHeight(gridPosition - vec2(1.0, 0.0));
+    float hz = chunkHeight(gridPosition + vec2(0.0, 1.0)) - chunkHeight(gridPosition - vec2(0.0, 1.0));
+
+    v_vertexColors = terrainColor(height);
+    v_vertexNormals = normalize(vec3(-hx, 2.0, -hz));
+    FragPos = u_ChunkOrigin + vec3(gridPosition.x, height, gridPosition.y);
+
+    gl_Position = u_Projection * u_ViewMatrix * vec4(FragPos, 1.0f);
+}
@@ -0,0 +1,20 @@
+// Chunk heights read by the tessellation stages
+
+uniform sampler2DArray u_Heights;
+// Heights are stored as fractions of this range
+uniform float u_HeightMin;
+uniform float u_HeightRange;
+uniform float u_Layer;
+uniform float u_ChunkCells;
+uniform vec3 u_ChunkOrigin;
+
+// Height at a position in cells from the chunk's first vertex, vertices
+// sit on texel centers
+float chunkHeight(vec2 gridPosition) {
+    vec2 uv = (gridPosition + 0.5) / (u_ChunkCells + 1.0);
+    return u_HeightMin + texture(u_Heights, vec3(uv, u_Layer)).r * u_HeightRange;
+}
+
+vec3 chunkPosition(vec2 gridPosition) {
+    return u_ChunkOrigin + vec3(gridPosition.x, chunkHeight(gridPosition), gridPosition.y);
+}
@@ -0,0 +1,10 @@
+#version 410 core
+
+// Patch corner, in cells from the chunk's first vertex
+layout(location=0) in vec2 gridPosition;
+
+out vec2 tc_gridPosition;
+
+void main() {
+    tc_gridPosition = gridPosition;
+}
@@ -1,20 +1,30 @@
 #version 410 core
+#include "frame.glsl"
 
 layout(location=0) in vec3 position;
 layout(location=1) in vec3 vertexNormals;
 layout(location=2) in vec3 vertexColors;
-layout(location=3) in vec3 offset;
 
 uniform mat4 u_ModelMatrix;
-uniform mat4 u_ViewMatrix;
-uniform mat4 u_Projection;
+// Origins of the chunk arena slots. Vertices drawn from the arena find
+// their chunk's origin from their index, everything else sets
+// u_SlotVertices to 0.
+uniform samplerBuffer u_SlotOrigins;
+uniform int u_SlotVertices;
 
 // Pass vertex colors into the fragment shader
 out vec3 v_vertexColors;
 out vec3 v_vertexNormals;
 out vec3 FragPos;
+// The depth pre-pass runs these same vertices with another fragment
+// shader, both must land on exactly the same depth
+invariant gl_Position;
 
 void main() {
+    vec3 offset = vec3(0.0f);
+    if (u_SlotVertices > 0) {
+        offset = texelFetch(u_SlotOrigins, gl_VertexID / u_SlotVertices).xyz;
+    }
     v_vertexColors = vertexColors;
     v_vertexNormals = vertexNormals;
     FragPos = vec3(u_ModelMatrix * vec4(position + offset, 1.0f));
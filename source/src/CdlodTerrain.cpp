@@ -0,0 +1,203 @@
+#include "CdlodTerrain.hpp"
+
+#include <cmath>
+#include <limits>
+
+// Each level is drawn out to this many times its node size
+static const float LOD_DISTANCE_RATIO = 2.0f;
+// Fraction of a level's range after which vertices start to morph
+static const float MORPH_START_RATIO = 0.7f;
+// Margin taken off every pick's slack, for rounding in the distances
+static const float SLACK_EPSILON = 1e-3f;
+
+CdlodTerrain::CdlodTerrain(int gridSize, float leafSize, int levels, glm::vec2 center){
+    m_gridSize = gridSize;
+    m_leafSize = leafSize;
+    m_levels = levels;
+    m_center = center;
+
+    for (int level = 0; level < m_levels; level++) {
+        m_ranges.push_back(m_leafSize * (1 << level) * LOD_DISTANCE_RATIO);
+    }
+
+    // One grid of (gridSize + 1)^2 vertices is shared by every node
+    std::vector<float> vertices;
+    std::vector<GLuint> indices;
+    int width = m_gridSize + 1;
+    for (int y = 0; y <= m_gridSize; y++) {
+        for (int x = 0; x <= m_gridSize; x++) {
+            vertices.push_back(x);
+            vertices.push_back(y);
+        }
+    }
+    // The full grid, then its first quarter for the parts of a node its
+    // children leave uncovered
+    for (int cells = m_gridSize; cells >= m_gridSize / 2; cells /= 2) {
+        for (int y = 0; y < cells; y++) {
+            for (int x = 0; x < cells; x++) {
+                int pos = x + y*width;
+                indices.push_back(pos + width);
+                indices.push_back(pos);
+                indices.push_back(pos + width + 1);
+                indices.push_back(pos + 1);
+                indices.push_back(pos + 1 + width);
+                indices.push_back(pos);
+            }
+        }
+        if (cells == m_gridSize) {
+            m_indexCount = indices.size();
+        }
+    }
+    m_quarterCount = indices.size() - m_indexCount;
+
+    glGenVertexArrays(1, &m_VAO);
+    glGenBuffers(1, &m_VBO);
+    glGenBuffers(1, &m_EBO);
+
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+}
+
+CdlodTerrain::~CdlodTerrain(){
+    glDeleteVertexArrays(1, &m_VAO);
+    glDeleteBuffers(1, &m_VBO);
+    glDeleteBuffers(1, &m_EBO);
+}
+
+void CdlodTerrain::Select(const glm::vec3& eye, float minHeight, float maxHeight){
+    float moved = glm::distance(eye, m_eye) + SLACK_EPSILON;
+    bool restart = m_picks.empty() || minHeight != m_minHeight || maxHeight != m_maxHeight;
+    m_eye = eye;
+    m_minHeight = minHeight;
+    m_maxHeight = maxHeight;
+
+    std::vector<Pick> previous;
+    previous.swap(m_picks);
+    if (restart) {
+        SelectNode(m_levels - 1, glm::ivec2(0), std::numeric_limits<float>::max());
+    } else {
+        // A pick with margin left has every test that led to it come out
+        // the same, so it stays as it is
+        m_repicked.clear();
+        for (int i = 0; i < previous.size(); i++) {
+            previous[i].slack -= moved;
+            if (previous[i].slack > 0.0f) {
+                m_picks.push_back(previous[i]);
+            } else {
+                Reselect(previous[i]);
+            }
+        }
+    }
+
+    m_selected.clear();
+    for (int i = 0; i < m_picks.size(); i++) {
+        if (m_picks[i].drawn) {
+            m_selected.push_back(m_picks[i].node);
+        }
+    }
+}
+
+void CdlodTerrain::Reselect(const Pick& pick){
+    // Coarsen from the highest ancestor that no longer splits, the picks
+    // below it are dropped as they come up. A node splits when part of
+    // it is in range of the next finer level.
+    float slack = std::numeric_limits<float>::max();
+    for (int level = m_levels - 1; level > pick.level; level--) {
+        glm::ivec2 index = pick.index >> (level - pick.level);
+        float distance = Distance(level, index);
+        if (distance > m_ranges[level - 1]) {
+            if (m_repicked.insert(std::make_pair(level, std::make_pair(index.x, index.y))).second) {
+                SelectNode(level, index, slack);
+            }
+            return;
+        }
+        slack = std::min(slack, m_ranges[level - 1] - distance);
+    }
+    // Every ancestor still splits, so this node is reached as before
+    SelectNode(pick.level, pick.index, slack);
+}
+
+glm::vec2 CdlodTerrain::NodeOrigin(int level, glm::ivec2 index) const{
+    float rootSize = NodeSize(m_levels - 1);
+    return m_center - glm::vec2(rootSize * 0.5f) + glm::vec2(index) * NodeSize(level);
+}
+
+float CdlodTerrain::NodeSize(int level) const{
+    return m_leafSize * (1 << level);
+}
+
+float CdlodTerrain::Distance(int level, glm::ivec2 index) const{
+    glm::vec2 origin = NodeOrigin(level, index);
+    float size = NodeSize(level);
+    glm::vec3 boxMin(origin.x, m_minHeight, origin.y);
+    glm::vec3 boxMax(origin.x + size, m_maxHeight, origin.y + size);
+    return glm::distance(glm::clamp(m_eye, boxMin, boxMax), m_eye);
+}
+
+void CdlodTerrain::SelectNode(int level, glm::ivec2 index, float slack){
+    glm::vec2 origin = NodeOrigin(level, index);
+    float size = NodeSize(level);
+    float distance = Distance(level, index);
+    slack = std::min(slack, std::abs(distance - m_ranges[level]));
+
+    // Out of range at its level: covered with a quarter of the parent's
+    // level, with that level's cell size and morph range so it matches
+    // the whole nodes of that level around it. Nothing for the root.
+    if (distance > m_ranges[level]) {
+        bool drawn = level < m_levels - 1;
+        m_picks.push_back({level, index, slack, drawn, {origin, size, level + 1, true}});
+        return;
+    }
+
+    // Finest level, or no part of the node is close enough for the next level
+    if (level > 0) {
+        slack = std::min(slack, std::abs(distance - m_ranges[level - 1]));
+    }
+    if (level == 0 || distance > m_ranges[level - 1]) {
+        m_picks.push_back({level, index, slack, true, {origin, size, level, false}});
+        return;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        SelectNode(level - 1, index * 2 + glm::ivec2(i & 1, i >> 1), slack);
+    }
+}
+
+void CdlodTerrain::Render(Shader& shader) const{
+    Shader::Uniform<float> gridSize = shader.GetUniform<float>("u_GridSize");
+    Shader::Uniform<glm::vec2> nodeOrigin = shader.GetUniform<glm::vec2>("u_NodeOrigin");
+    Shader::Uniform<float> nodeSize = shader.GetUniform<float>("u_NodeSize");
+    Shader::Uniform<glm::vec2> morphRange = shader.GetUniform<glm::vec2>("u_MorphRange");
+
+    glBindVertexArray(m_VAO);
+    for (int i = 0; i < m_selected.size(); i++) {
+        const Node& node = m_selected[i];
+        float morphEnd = m_ranges[node.level];
+        float morphStart = morphEnd * MORPH_START_RATIO;
+
+        nodeOrigin.Set(node.origin);
+        nodeSize.Set(node.size);
+        morphRange.Set(glm::vec2(morphStart, morphEnd));
+        if (node.quarter) {
+            gridSize.Set((float)(m_gridSize / 2));
+            glDrawElements(GL_TRIANGLES, m_quarterCount, GL_UNSIGNED_INT, (void*)(m_indexCount * sizeof(GLuint)));
+        } else {
+            gridSize.Set((float)m_gridSize);
+            glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0);
+        }
+    }
+}
+
+int CdlodTerrain::GetSelectedCount() const{
+    return m_selected.size();
+}
+
+float CdlodTerrain::GetViewDistance() const{
+    return m_ranges[m_levels - 1];
+}
@@ -0,0 +1,250 @@
+#include "ChunkArena.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+// Each attribute is a vec3 of floats
+static const GLsizeiptr VERTEX_SIZE = 3 * sizeof(float);
+
+ChunkArena::ChunkArena(GLsizei slotVertices, int initialSlots)
+    : m_staging(slotVertices * VERTEX_SIZE, STAGING_REGIONS){
+    m_slotVertices = slotVertices;
+    m_mappedSlot = -1;
+    m_mappedAttribute = 0;
+    m_capacity = 0;
+    m_indexCapacity = 0;
+
+    glGenVertexArrays(1, &m_VAO);
+    glGenBuffers(3, m_VBO);
+    glGenBuffers(1, &m_EBO);
+    glGenBuffers(1, &m_originBuffer);
+    glGenTextures(1, &m_originTexture);
+
+    Grow(initialSlots > 0 ? initialSlots : 1);
+}
+
+ChunkArena::~ChunkArena(){
+    glDeleteVertexArrays(1, &m_VAO);
+    glDeleteBuffers(3, m_VBO);
+    glDeleteBuffers(1, &m_EBO);
+    glDeleteBuffers(1, &m_originBuffer);
+    glDeleteTextures(1, &m_originTexture);
+}
+
+int ChunkArena::Allocate(){
+    if (m_freeSlots.empty()) {
+        Grow(m_capacity * 2);
+    }
+    int slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+    return slot;
+}
+
+void ChunkArena::Free(int slot){
+    if (slot < 0 || slot >= m_capacity) {
+        std::cout << "[ChunkArena] tried to free invalid slot " << slot << "\n";
+        return;
+    }
+    m_freeSlots.push_back(slot);
+}
+
+void ChunkArena::Upload(int slot, const float* positions, const float* normals, const float* colors){
+    UploadAttribute(slot, POSITION, positions);
+    UploadAttribute(slot, NORMAL, normals);
+    UploadAttribute(slot, COLOR, colors);
+}
+
+void ChunkArena::UploadAttribute(int slot, int attribute, const float* data){
+    FloatSpan span = MapAttribute(slot, attribute);
+    if (span.data) {
+        std::memcpy(span.data, data, span.size * sizeof(float));
+    }
+    // Without staging memory the data is sent directly
+    if (!UnmapAttribute()) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_VBO[attribute]);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)slot * m_slotVertices * VERTEX_SIZE,
+                        m_slotVertices * VERTEX_SIZE, data);
+    }
+}
+
+FloatSpan ChunkArena::MapAttribute(int slot, int attribute){
+    m_mappedSlot = slot;
+    m_mappedAttribute = attribute;
+    float* data = (float*)m_staging.Map(m_slotVertices * VERTEX_SIZE);
+    return FloatSpan(data, data ? m_slotVertices * 3 : 0);
+}
+
+bool ChunkArena::UnmapAttribute(){
+    if (m_mappedSlot < 0) {
+        std::cout << "[ChunkArena] no attribute is mapped\n";
+        return false;
+    }
+    GLintptr offset = (GLintptr)m_mappedSlot * m_slotVertices * VERTEX_SIZE;
+    m_mappedSlot = -1;
+    return m_staging.Unmap(m_VBO[m_mappedAttribute], offset);
+}
+
+void ChunkArena::SetOrigin(int slot, const glm::vec3& origin){
+    float* texel = &m_origins[slot * 4];
+    texel[0] = origin.x;
+    texel[1] = origin.y;
+    texel[2] = origin.z;
+    glBindBuffer(GL_TEXTURE_BUFFER, m_originBuffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, slot * 4 * sizeof(float), 4 * sizeof(float), texel);
+}
+
+GLsizei ChunkArena::AddIndices(const std::vector<int>& indices){
+    GLsizei first = m_indices.size();
+    m_indices.insert(m_indices.end(), indices.begin(), indices.end());
+    UploadIndices(first, indices.size());
+    return first;
+}
+
+GLsizei ChunkArena::AllocateIndices(const std::vector<int>& indices){
+    return AllocateIndices(indices.data(), indices.size());
+}
+
+GLsizei ChunkArena::AllocateIndices(const int* indices, GLsizei count){
+    for (int i = 0; i < m_freeIndices.size(); i++) {
+        IndexRange& range = m_freeIndices[i];
+        if (range.count < count) {
+            continue;
+        }
+        GLsizei first = range.first;
+        range.first += count;
+        range.count -= count;
+        if (range.count == 0) {
+            m_freeIndices.erase(m_freeIndices.begin() + i);
+        }
+        std::memcpy(m_indices.data() + first, indices, count * sizeof(int));
+        UploadIndices(first, count);
+        return first;
+    }
+    GLsizei first = m_indices.size();
+    m_indices.resize(first + count);
+    std::memcpy(m_indices.data() + first, indices, count * sizeof(int));
+    UploadIndices(first, count);
+    return first;
+}
+
+void ChunkArena::FreeIndices(GLsizei first, GLsizei count){
+    if (count <= 0) {
+        return;
+    }
+    if (first < 0 || first + count > (GLsizei)m_indices.size()) {
+        std::cout << "[ChunkArena] tried to free invalid index range " << first << "+" << count << "\n";
+        return;
+    }
+
+    // Keep the free ranges sorted and merge the ones that touch
+    int i = 0;
+    while (i < m_freeIndices.size() && m_freeIndices[i].first < first) {
+        i++;
+    }
+    m_freeIndices.insert(m_freeIndices.begin() + i, IndexRange{first, count});
+    if (i + 1 < m_freeIndices.size() && first + count == m_freeIndices[i + 1].first) {
+        m_freeIndices[i].count += m_freeIndices[i + 1].count;
+        m_freeIndices.erase(m_freeIndices.begin() + i + 1);
+    }
+    if (i > 0 && m_freeIndices[i - 1].first + m_freeIndices[i - 1].count == first) {
+        m_freeIndices[i - 1].count += m_freeIndices[i].count;
+        m_freeIndices.erase(m_freeIndices.begin() + i);
+    }
+}
+
+void ChunkArena::Bind() const{
+    glBindVertexArray(m_VAO);
+}
+
+void ChunkArena::BindOrigins(GLenum textureUnit) const{
+    glActiveTexture(textureUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, m_originTexture);
+}
+
+void ChunkArena::Draw(int slot, GLsizei count, GLsizei firstIndex) const{
+    glDrawElementsBaseVertex(GL_TRIANGLES, count, GL_UNSIGNED_INT,
+                             (void*)(firstIndex * sizeof(int)), GetBaseVertex(slot));
+}
+
+void ChunkArena::MultiDraw(const int* slots, const GLsizei* counts, const GLsizei* firstIndices, int drawCount) const{
+    std::vector<const void*> offsets(drawCount);
+    std::vector<GLint> baseVertices(drawCount);
+    for (int i = 0; i < drawCount; i++) {
+        offsets[i] = (const void*)(firstIndices[i] * sizeof(int));
+        baseVertices[i] = GetBaseVertex(slots[i]);
+    }
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts, GL_UNSIGNED_INT, offsets.data(), drawCount, baseVertices.data());
+}
+
+GLint ChunkArena::GetBaseVertex(int slot) const{
+    return slot * m_slotVertices;
+}
+
+GLsizei ChunkArena::GetSlotVertices() const{
+    return m_slotVertices;
+}
+
+int ChunkArena::GetCapacity() const{
+    return m_capacity;
+}
+
+void ChunkArena::Grow(int newCapacity){
+    GLsizeiptr oldSize = (GLsizeiptr)m_capacity * m_slotVertices * VERTEX_SIZE;
+    GLsizeiptr newSize = (GLsizeiptr)newCapacity * m_slotVertices * VERTEX_SIZE;
+
+    for (int i = 0; i < 3; i++) {
+        GLuint buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_DYNAMIC_DRAW);
+
+        // Keep the chunks that already live in the arena
+        if (oldSize > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, m_VBO[i]);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+        }
+        glDeleteBuffers(1, &m_VBO[i]);
+        m_VBO[i] = buffer;
+    }
+
+    // The origins are small enough to simply be sent again
+    m_origins.resize(newCapacity * 4, 0.0f);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_originBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, m_origins.size() * sizeof(float), m_origins.data(), GL_DYNAMIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, m_originTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_originBuffer);
+
+    // Hand out the lowest slots first
+    for (int slot = newCapacity - 1; slot >= m_capacity; slot--) {
+        m_freeSlots.push_back(slot);
+    }
+    m_capacity = newCapacity;
+
+    SetupVertexArray();
+}
+
+void ChunkArena::UploadIndices(GLsizei first, GLsizei count){
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+
+    // Double the index buffer when it is full, otherwise only the new
+    // range is sent
+    if (m_indices.size() > m_indexCapacity) {
+        m_indexCapacity = std::max(m_indexCapacity * 2, (GLsizei)m_indices.size());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indexCapacity * sizeof(int), nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, m_indices.size() * sizeof(int), m_indices.data());
+        return;
+    }
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, first * sizeof(int), count * sizeof(int), m_indices.data() + first);
+}
+
+void ChunkArena::SetupVertexArray(){
+    glBindVertexArray(m_VAO);
+    for (int i = 0; i < 3; i++) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBO[i]);
+        glVertexAttribPointer(i, 3, GL_FLOAT, GL_FALSE, VERTEX_SIZE, (void*)0);
+        glEnableVertexAttribArray(i);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+}
@@ -0,0 +1,186 @@
+#include "ChunkLod.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+ChunkLod::ChunkLod(ChunkArena& arena, int cells, int blocks){
+    m_cells = cells;
+
+    for (int level = 0; level < LEVELS; level++) {
+        int stride = 1 << level;
+
+        // All blocks go in one upload, so the whole body is one range too
+        int blockCells = std::max(cells / blocks, stride);
+        m_bodyBlocks[level] = cells / blockCells;
+        std::vector<int> body;
+        for (int by = 0; by < m_bodyBlocks[level]; by++) {
+            for (int bx = 0; bx < m_bodyBlocks[level]; bx++) {
+                std::vector<int> block = BuildBody(stride, bx * blockCells, by * blockCells, (bx + 1) * blockCells, (by + 1) * blockCells);
+                Range range;
+                range.first = body.size();
+                range.count = block.size();
+                m_bodyBlockRanges[level].push_back(range);
+                body.insert(body.end(), block.begin(), block.end());
+            }
+        }
+        m_bodies[level].first = arena.AddIndices(body);
+        m_bodies[level].count = body.size();
+        for (int i = 0; i < m_bodyBlockRanges[level].size(); i++) {
+            m_bodyBlockRanges[level][i].first += m_bodies[level].first;
+        }
+
+        for (int side = 0; side < 4; side++) {
+            for (int neighbor = 0; neighbor < LEVELS; neighbor++) {
+                // A finer neighbour stitches itself to us instead
+                if (neighbor < level) {
+                    m_edges[level][side][neighbor] = m_edges[level][side][level];
+                    continue;
+                }
+                std::vector<int> edge = BuildEdge(stride, side, 1 << neighbor);
+                m_edges[level][side][neighbor].first = arena.AddIndices(edge);
+                m_edges[level][side][neighbor].count = edge.size();
+            }
+        }
+    }
+}
+
+ChunkLod::Range ChunkLod::GetBody(int level) const{
+    return m_bodies[level];
+}
+
+int ChunkLod::GetBodyBlocks(int level) const{
+    return m_bodyBlocks[level];
+}
+
+ChunkLod::Range ChunkLod::GetBodyBlock(int level, int bx, int by) const{
+    return m_bodyBlockRanges[level][bx + by * m_bodyBlocks[level]];
+}
+
+ChunkLod::Range ChunkLod::GetEdge(int level, int side, int neighborLevel) const{
+    return m_edges[level][side][std::max(neighborLevel, level)];
+}
+
+int ChunkLod::EdgeVertex(int side, int t, int d) const{
+    // Each side is the south side turned by a quarter turn, which keeps
+    // the winding of the triangles the same on every side
+    int x, y;
+    if (side == SOUTH) {
+        x = t; y = d;
+    } else if (side == EAST) {
+        x = m_cells - d; y = t;
+    } else if (side == NORTH) {
+        x = m_cells - t; y = m_cells - d;
+    } else {
+        x = d; y = m_cells - t;
+    }
+    return x + y * (m_cells + 1);
+}
+
+std::vector<int> ChunkLod::BuildEdge(int stride, int side, int neighborStride) const{
+    std::vector<int> indices;
+    std::vector<int> outer;
+    std::vector<int> inner;
+
+    // The outer row only uses the vertices the neighbour also has
+    for (int t = 0; t <= m_cells; t += neighborStride) {
+        outer.push_back(t);
+    }
+    // The inner row stops short of the corners, which the sides share
+    for (int t = stride; t <= m_cells - stride; t += stride) {
+        inner.push_back(t);
+    }
+
+    // Zip the two rows together, always advancing the row whose next
+    // vertex comes first along the edge
+    int o = 0;
+    int i = 0;
+    while (o + 1 < outer.size() || i + 1 < inner.size()) {
+        bool advanceOuter = i + 1 >= inner.size() || (o + 1 < outer.size() && outer[o+1] <= inner[i+1]);
+        if (advanceOuter) {
+            indices.push_back(EdgeVertex(side, outer[o], 0));
+            indices.push_back(EdgeVertex(side, outer[o+1], 0));
+            indices.push_back(EdgeVertex(side, inner[i], stride));
+            o++;
+        } else {
+            indices.push_back(EdgeVertex(side, outer[o], 0));
+            indices.push_back(EdgeVertex(side, inner[i+1], stride));
+            indices.push_back(EdgeVertex(side, inner[i], stride));
+            i++;
+        }
+    }
+
+    return indices;
+}
+
+std::vector<int> ChunkLod::BuildBody(int stride, int x0, int y0, int x1, int y1) const{
+    std::vector<int> indices;
+    int width = m_cells + 1;
+
+    // Same triangulation as the full resolution grid, with a wider stride
+    for (int y = std::max(y0, stride); y < y1 && y + stride <= m_cells - stride; y += stride) {
+        for (int x = std::max(x0, stride); x < x1 && x + stride <= m_cells - stride; x += stride) {
+            int pos = x + y*width;
+            indices.push_back(pos + stride*width);
+            indices.push_back(pos);
+            indices.push_back(pos + stride*width + stride);
+            indices.push_back(pos + stride);
+            indices.push_back(pos + stride + stride*width);
+            indices.push_back(pos);
+        }
+    }
+
+    return indices;
+}
+
+std::vector<float> ChunkLod::ComputeErrors(const std::vector<float>& vertices, int cells){
+    std::vector<float> errors(LEVELS, 0.0f);
+    int width = cells + 1;
+
+    for (int level = 1; level < LEVELS; level++) {
+        int stride = 1 << level;
+        float maxError = 0;
+
+        for (int cy = 0; cy < cells; cy += stride) {
+            for (int cx = 0; cx < cells; cx += stride) {
+                float h00 = vertices[(cx + cy*width)*3 + 1];
+                float h10 = vertices[(cx + stride + cy*width)*3 + 1];
+                float h01 = vertices[(cx + (cy + stride)*width)*3 + 1];
+                float h11 = vertices[(cx + stride + (cy + stride)*width)*3 + 1];
+
+                // Compare every skipped vertex with the coarse triangles,
+                // which are split along the (0, 0) - (1, 1) diagonal
+                for (int y = 0; y <= stride; y++) {
+                    for (int x = 0; x <= stride; x++) {
+                        float u = (float)x / stride;
+                        float v = (float)y / stride;
+                        float coarse;
+                        if (u >= v) {
+                            coarse = h00 + u * (h10 - h00) + v * (h11 - h10);
+                        } else {
+                            coarse = h00 + v * (h01 - h00) + u * (h11 - h01);
+                        }
+                        float height = vertices[(cx + x + (cy + y)*width)*3 + 1];
+                        maxError = std::max(maxError, std::fabs(height - coarse));
+                    }
+                }
+            }
+        }
+
+        // A coarser level is never more accurate than a finer one
+        errors[level] = std::max(maxError, errors[level - 1]);
+    }
+
+    return errors;
+}
+
+int ChunkLod::SelectLevel(const std::vector<float>& errors, float distance, float projectionScale, float maxPixelError){
+    if (distance <= 0) {
+        return 0;
+    }
+    for (int level = LEVELS - 1; level > 0; level--) {
+        if (errors[level] * projectionScale / distance <= maxPixelError) {
+            return level;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "ChunkPipeline.hpp"
+
+#include <iostream>
+
+int ChunkPipeline::AddStage(const std::string& name, ConfigFunction config, const std::vector<int>& inputs, StageFunction compute){
+    Stage stage;
+    stage.name = name;
+    stage.configFunction = config;
+    stage.config = config();
+    stage.inputs = inputs;
+    stage.compute = compute;
+    m_stages.push_back(stage);
+    return m_stages.size() - 1;
+}
+
+int ChunkPipeline::AddStage(const std::string& name, ConfigFunction config, const std::vector<int>& inputs, size_t size, WriteFunction write){
+    // Cached outputs are written into a vector of the stage's size
+    int stage = AddStage(name, config, inputs,
+        [size, write](int x, int y, uint64_t key, const std::vector<const std::vector<float>*>& inputs) {
+            std::vector<float> out(size);
+            write(x, y, key, inputs, FloatSpan(out));
+            return out;
+        });
+    m_stages[stage].write = write;
+    m_stages[stage].size = size;
+    return stage;
+}
+
+void ChunkPipeline::Refresh(){
+    for (int i = 0; i < m_stages.size(); i++) {
+        m_stages[i].config = m_stages[i].configFunction();
+    }
+}
+
+uint64_t ChunkPipeline::GetKey(int stage, int x, int y) const{
+    Fingerprint key = m_stages[stage].config;
+    return key.Add(x).Add(y).GetValue();
+}
+
+const std::vector<float>& ChunkPipeline::Get(int stage, int x, int y){
+    uint64_t key = GetKey(stage, x, y);
+    // Map nodes never move, so this stays valid while the inputs are built
+    Artifact& artifact = m_stages[stage].artifacts[std::make_pair(x, y)];
+    if (artifact.valid && artifact.key == key) {
+        return artifact.data;
+    }
+
+    artifact.data = m_stages[stage].compute(x, y, key, GetInputs(stage, x, y));
+    artifact.key = key;
+    artifact.valid = true;
+    m_stages[stage].runs++;
+    return artifact.data;
+}
+
+bool ChunkPipeline::Write(int stage, int x, int y, FloatSpan out){
+    if (!m_stages[stage].write || out.size < m_stages[stage].size) {
+        std::cout << "[ChunkPipeline] cannot write stage " << m_stages[stage].name << " into " << out.size << " floats\n";
+        return false;
+    }
+    m_stages[stage].write(x, y, GetKey(stage, x, y), GetInputs(stage, x, y), out);
+    m_stages[stage].runs++;
+    return true;
+}
+
+std::vector<const std::vector<float>*> ChunkPipeline::GetInputs(int stage, int x, int y){
+    std::vector<const std::vector<float>*> inputs;
+    for (int i = 0; i < m_stages[stage].inputs.size(); i++) {
+        inputs.push_back(&Get(m_stages[stage].inputs[i], x, y));
+    }
+    return inputs;
+}
+
+void ChunkPipeline::Evict(int x, int y){
+    for (int i = 0; i < m_stages.size(); i++) {
+        m_stages[i].artifacts.erase(std::make_pair(x, y));
+    }
+}
+
+int ChunkPipeline::TakeRunCount(int stage){
+    int runs = m_stages[stage].runs;
+    m_stages[stage].runs = 0;
+    return runs;
+}
+
+const std::string& ChunkPipeline::GetName(int stage) const{
+    return m_stages[stage].name;
+}
+
+int ChunkPipeline::GetStageCount() const{
+    return m_stages.size();
+}
@@ -0,0 +1,370 @@
+#include "ChunkStore.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <filesystem>
+#include <algorithm>
+
+#if defined(LINUX) || defined(MAC)
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+// Every region file starts with this tag and version
+static const uint32_t REGION_MAGIC = 0x47525450; // "PTRG"
+static const uint32_t REGION_VERSION = 1;
+static const int REGION_CHUNKS = ChunkStore::REGION_SIZE * ChunkStore::REGION_SIZE;
+static const size_t HEADER_SIZE = 2 * sizeof(uint32_t) + REGION_CHUNKS * sizeof(ChunkStore::RegionEntry);
+// Slots are rounded up to this, so a payload that grows a little still fits
+static const uint32_t SLOT_ALIGNMENT = 512;
+// Address range first set aside for a region mapping to grow into
+static const size_t REGION_RESERVE = (size_t)1 << 30;
+// Dead slots a region has before it may be compacted
+static const size_t COMPACT_MIN_DEAD = (size_t)1 << 20;
+
+// Rounds towards negative infinity so negative chunks land in the right region
+static int floorDiv(int a, int b){
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+ChunkStore::ChunkStore(const std::string& directory){
+    m_directory = directory;
+
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    if (error) {
+        Log("ChunkStore", "could not create the store directory");
+    }
+}
+
+ChunkStore::~ChunkStore(){
+    while (!m_regions.empty()) {
+        UnmapRegion(m_regions.begin()->first.first, m_regions.begin()->first.second);
+    }
+}
+
+void ChunkStore::Log(const char* system, const char* message){
+    std::cout << "[" << system << "]" << message << "\n";
+}
+
+const std::string& ChunkStore::GetDirectory() const{
+    return m_directory;
+}
+
+std::string ChunkStore::RegionPath(int rx, int ry) const{
+    std::stringstream path;
+    path << m_directory << "/r." << rx << "." << ry << ".bin";
+    return path.str();
+}
+
+bool ChunkStore::Load(int x, int y, std::vector<char>& out){
+    int rx = floorDiv(x, REGION_SIZE);
+    int ry = floorDiv(y, REGION_SIZE);
+
+    const MappedRegion* region = MapRegion(rx, ry);
+    if (region == nullptr) {
+        return false;
+    }
+
+    // Look up the chunk in the region header
+    int index = (x - rx * REGION_SIZE) + (y - ry * REGION_SIZE) * REGION_SIZE;
+    RegionEntry entry;
+    std::memcpy(&entry, region->data + 2 * sizeof(uint32_t) + index * sizeof(RegionEntry), sizeof(RegionEntry));
+
+    if (entry.size == 0) {
+        return false;
+    }
+    if (entry.offset < HEADER_SIZE || entry.offset + entry.size > region->size) {
+        Log("ChunkStore", "region index points outside of the file");
+        return false;
+    }
+
+    out.assign(region->data + entry.offset, region->data + entry.offset + entry.size);
+    return true;
+}
+
+// Write 'size' bytes at 'offset' of a region file
+static bool writeRegion(int file, const std::string& path, uint64_t offset, const void* data, size_t size){
+#if defined(LINUX) || defined(MAC)
+    // The file is open already, 'path' is only for the fallback
+    (void)path;
+    const char* bytes = (const char*)data;
+    while (size > 0) {
+        ssize_t written = pwrite(file, bytes, size, offset);
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        offset += written;
+        size -= written;
+    }
+    return true;
+#else
+    std::fstream stream(path, std::ios::in | std::ios::out | std::ios::binary);
+    stream.seekp(offset, std::ios::beg);
+    stream.write((const char*)data, size);
+    return stream.good();
+#endif
+}
+
+bool ChunkStore::Save(int x, int y, const void* data, size_t size){
+    int rx = floorDiv(x, REGION_SIZE);
+    int ry = floorDiv(y, REGION_SIZE);
+    std::string path = RegionPath(rx, ry);
+
+    MappedRegion* region = CreateRegion(rx, ry);
+    if (region == nullptr) {
+        return false;
+    }
+
+    int index = (x - rx * REGION_SIZE) + (y - ry * REGION_SIZE) * REGION_SIZE;
+    size_t entryOffset = 2 * sizeof(uint32_t) + index * sizeof(RegionEntry);
+    RegionEntry entry;
+    std::memcpy(&entry, region->data + entryOffset, sizeof(RegionEntry));
+
+    // Reuse the chunk's slot when the payload fits, otherwise the old
+    // slot is left dead and a new one is added at the end of the file
+    uint32_t room = (entry.reserved != 0) ? entry.reserved : entry.size;
+    bool append = (entry.size == 0 || size > room);
+    if (append) {
+        if (entry.size != 0) {
+            region->dead += room;
+        }
+        entry.offset = region->size;
+        entry.reserved = (uint32_t)((size + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT);
+    }
+    entry.size = (uint32_t)size;
+
+    bool written = writeRegion(region->file, path, entry.offset, data, size);
+    if (written && append && entry.reserved > size) {
+        // Pad the slot so the next one starts aligned
+        std::vector<char> padding(entry.reserved - size, 0);
+        written = writeRegion(region->file, path, entry.offset + size, padding.data(), padding.size());
+    }
+    // The index is only pointed at the payload once it is written
+    written = written && writeRegion(region->file, path, entryOffset, &entry, sizeof(RegionEntry));
+    if (!written) {
+        Log("ChunkStore", "failed to write chunk to region file");
+        UnmapRegion(rx, ry);
+        return false;
+    }
+
+    if (!GrowRegion(rx, ry, std::max(region->size, (size_t)(entry.offset + entry.reserved)))) {
+        // The chunk is written, the region is just mapped again on the next read
+        UnmapRegion(rx, ry);
+        return true;
+    }
+    if (region->dead > COMPACT_MIN_DEAD && region->dead > region->size - HEADER_SIZE - region->dead) {
+        CompactRegion(rx, ry);
+    }
+    return true;
+}
+
+ChunkStore::MappedRegion* ChunkStore::CreateRegion(int rx, int ry){
+    MappedRegion* region = MapRegion(rx, ry);
+    if (region != nullptr) {
+        return region;
+    }
+
+    // Start a new region file with an empty header
+    std::string path = RegionPath(rx, ry);
+    std::ofstream create(path, std::ios::binary);
+    uint32_t tag[2] = { REGION_MAGIC, REGION_VERSION };
+    create.write((const char*)tag, sizeof(tag));
+    std::vector<char> emptyIndex(REGION_CHUNKS * sizeof(RegionEntry), 0);
+    create.write(emptyIndex.data(), emptyIndex.size());
+    create.close();
+
+    region = MapRegion(rx, ry);
+    if (region == nullptr) {
+        Log("ChunkStore", "could not create region file");
+    }
+    return region;
+}
+
+void ChunkStore::CompactRegion(int rx, int ry){
+    MappedRegion* region = MapRegion(rx, ry);
+    if (region == nullptr) {
+        return;
+    }
+
+    // Copy the header and every live slot, in index order, to a new file
+    std::vector<char> contents(region->data, region->data + HEADER_SIZE);
+    for (int i = 0; i < REGION_CHUNKS; i++) {
+        size_t entryOffset = 2 * sizeof(uint32_t) + i * sizeof(RegionEntry);
+        RegionEntry entry;
+        std::memcpy(&entry, &contents[entryOffset], sizeof(RegionEntry));
+        if (entry.size == 0) {
+            continue;
+        }
+        const char* payload = region->data + entry.offset;
+        entry.offset = contents.size();
+        entry.reserved = (entry.size + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+        contents.insert(contents.end(), payload, payload + entry.size);
+        contents.resize(entry.offset + entry.reserved, 0);
+        std::memcpy(&contents[entryOffset], &entry, sizeof(RegionEntry));
+    }
+
+    std::string path = RegionPath(rx, ry);
+    std::string compacted = path + ".tmp";
+    std::ofstream file(compacted, std::ios::binary);
+    file.write(contents.data(), contents.size());
+    file.close();
+    if (!file) {
+        Log("ChunkStore", "could not write compacted region file");
+        return;
+    }
+
+    // The region is mapped again from the new file on the next access
+    UnmapRegion(rx, ry);
+    std::error_code error;
+    std::filesystem::rename(compacted, path, error);
+    if (error) {
+        Log("ChunkStore", "could not replace region file with its compacted copy");
+    }
+}
+
+ChunkStore::MappedRegion* ChunkStore::MapRegion(int rx, int ry){
+    std::pair<int, int> key(rx, ry);
+    std::map<std::pair<int, int>, MappedRegion>::iterator it = m_regions.find(key);
+    if (it != m_regions.end()) {
+        return &it->second;
+    }
+
+    std::string path = RegionPath(rx, ry);
+    MappedRegion region;
+
+#if defined(LINUX) || defined(MAC)
+    int fd = open(path.c_str(), O_RDWR);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < HEADER_SIZE) {
+        close(fd);
+        return nullptr;
+    }
+    // Set aside room for the region to grow, then map the file over its start
+    region.reserved = REGION_RESERVE;
+    while (region.reserved < (size_t)info.st_size) {
+        region.reserved *= 2;
+    }
+    void* range = mmap(nullptr, region.reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    void* data = MAP_FAILED;
+    if (range != MAP_FAILED) {
+        data = mmap(range, info.st_size, PROT_READ, MAP_SHARED | MAP_FIXED, fd, 0);
+        if (data == MAP_FAILED) {
+            munmap(range, region.reserved);
+        }
+    }
+    if (data == MAP_FAILED) {
+        close(fd);
+        Log("ChunkStore", "could not map region file");
+        return nullptr;
+    }
+    region.data = (const char*)data;
+    region.size = info.st_size;
+    region.file = fd;
+#else
+    // No mmap here, so read the whole region file instead
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return nullptr;
+    }
+    size_t size = file.tellg();
+    if (size < HEADER_SIZE) {
+        return nullptr;
+    }
+    char* data = new char[size];
+    file.seekg(0, std::ios::beg);
+    file.read(data, size);
+    region.data = data;
+    region.size = size;
+#endif
+
+    uint32_t tag[2];
+    std::memcpy(tag, region.data, sizeof(tag));
+    m_regions[key] = region;
+    if (tag[0] != REGION_MAGIC || tag[1] != REGION_VERSION) {
+        Log("ChunkStore", "region file has an unknown format");
+        UnmapRegion(rx, ry);
+        return nullptr;
+    }
+
+    // Whatever no chunk's slot covers is dead
+    size_t live = 0;
+    for (int i = 0; i < REGION_CHUNKS; i++) {
+        RegionEntry entry;
+        std::memcpy(&entry, region.data + 2 * sizeof(uint32_t) + i * sizeof(RegionEntry), sizeof(RegionEntry));
+        if (entry.size != 0) {
+            live += (entry.reserved != 0) ? entry.reserved : entry.size;
+        }
+    }
+    m_regions[key].dead = (region.size - HEADER_SIZE > live) ? region.size - HEADER_SIZE - live : 0;
+    return &m_regions[key];
+}
+
+bool ChunkStore::GrowRegion(int rx, int ry, size_t size){
+    MappedRegion& region = m_regions[std::pair<int, int>(rx, ry)];
+#if defined(LINUX) || defined(MAC)
+    // Writes show through the shared mapping, only new pages need mapping
+    if (size <= region.size) {
+        return true;
+    }
+    if (size > region.reserved) {
+        // Out of room, move the mapping to a bigger range
+        size_t reserved = region.reserved * 2;
+        while (reserved < size) {
+            reserved *= 2;
+        }
+        void* range = mmap(nullptr, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (range == MAP_FAILED) {
+            Log("ChunkStore", "could not reserve room for region file");
+            return false;
+        }
+        munmap((void*)region.data, region.reserved);
+        region.data = (const char*)range;
+        region.reserved = reserved;
+        region.size = 0;
+    }
+    void* data = mmap((void*)region.data, size, PROT_READ, MAP_SHARED | MAP_FIXED, region.file, 0);
+    if (data == MAP_FAILED) {
+        Log("ChunkStore", "could not map region file");
+        return false;
+    }
+    region.size = size;
+    return true;
+#else
+    // No mapping here, so read the file again to see what was written
+    std::ifstream file(RegionPath(rx, ry), std::ios::binary | std::ios::ate);
+    if (!file.is_open() || (size_t)file.tellg() < size) {
+        return false;
+    }
+    size = file.tellg();
+    char* data = new char[size];
+    file.seekg(0, std::ios::beg);
+    file.read(data, size);
+    delete[] region.data;
+    region.data = data;
+    region.size = size;
+    return true;
+#endif
+}
+
+void ChunkStore::UnmapRegion(int rx, int ry){
+    std::map<std::pair<int, int>, MappedRegion>::iterator it = m_regions.find(std::pair<int, int>(rx, ry));
+    if (it == m_regions.end()) {
+        return;
+    }
+#if defined(LINUX) || defined(MAC)
+    munmap((void*)it->second.data, it->second.reserved);
+    close(it->second.file);
+#else
+    delete[] it->second.data;
+#endif
+    m_regions.erase(it);
+}
@@ -0,0 +1,153 @@
+#include "FarFieldRing.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+FarFieldRing::FarFieldRing(int tileCells, float spacing, int radius, HeightFunction heightFunction, ColorFunction colorFunction)
+    : m_arena((tileCells + 1) * (tileCells + 1), (2 * radius + 1) * (2 * radius + 1)){
+    m_tileCells = tileCells;
+    m_spacing = spacing;
+    m_tileSize = tileCells * spacing;
+    m_radius = radius;
+    m_heightFunction = heightFunction;
+    m_colorFunction = colorFunction;
+
+    // Every tile is the same grid
+    std::vector<int> indices;
+    int width = tileCells + 1;
+    for (int y = 0; y < tileCells; y++) {
+        for (int x = 0; x < tileCells; x++) {
+            int pos = x + y*width;
+            indices.push_back(pos + width);
+            indices.push_back(pos);
+            indices.push_back(pos + width + 1);
+            indices.push_back(pos + 1);
+            indices.push_back(pos + 1 + width);
+            indices.push_back(pos);
+        }
+    }
+    m_indexFirst = m_arena.AddIndices(indices);
+    m_indexCount = indices.size();
+}
+
+void FarFieldRing::Update(const glm::vec3& eye, float innerRadius, int budget){
+    float outerRadius = GetViewDistance();
+
+    for (auto it = m_tiles.begin(); it != m_tiles.end();) {
+        if (NearestDistance(it->first, eye) > outerRadius) {
+            m_arena.Free(it->second);
+            it = m_tiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Missing tiles are generated nearest first, so the horizon fills in
+    // from the inside out
+    int eyeX = (int)std::floor(eye.x / m_tileSize);
+    int eyeY = (int)std::floor(eye.z / m_tileSize);
+    std::vector<std::pair<float, TileKey>> missing;
+    m_drawSlots.clear();
+    for (int y = eyeY - m_radius; y <= eyeY + m_radius; y++) {
+        for (int x = eyeX - m_radius; x <= eyeX + m_radius; x++) {
+            TileKey key(x, y);
+            float nearest = NearestDistance(key, eye);
+            if (nearest > outerRadius || FurthestDistance(key, eye) < innerRadius) {
+                continue;
+            }
+            auto tile = m_tiles.find(key);
+            if (tile != m_tiles.end()) {
+                m_drawSlots.push_back(tile->second);
+            } else {
+                missing.push_back(std::make_pair(nearest, key));
+            }
+        }
+    }
+
+    std::sort(missing.begin(), missing.end());
+    for (int i = 0; i < missing.size() && i < budget; i++) {
+        GenerateTile(missing[i].second);
+        m_drawSlots.push_back(m_tiles[missing[i].second]);
+    }
+}
+
+void FarFieldRing::Invalidate(){
+    for (auto it = m_tiles.begin(); it != m_tiles.end(); ++it) {
+        m_arena.Free(it->second);
+    }
+    m_tiles.clear();
+    m_drawSlots.clear();
+}
+
+void FarFieldRing::Render() const{
+    if (m_drawSlots.empty()) {
+        return;
+    }
+    std::vector<GLsizei> counts(m_drawSlots.size(), m_indexCount);
+    std::vector<GLsizei> firstIndices(m_drawSlots.size(), m_indexFirst);
+    m_arena.Bind();
+    m_arena.MultiDraw(m_drawSlots.data(), counts.data(), firstIndices.data(), m_drawSlots.size());
+}
+
+int FarFieldRing::GetTileCount() const{
+    return m_drawSlots.size();
+}
+
+float FarFieldRing::GetViewDistance() const{
+    return m_radius * m_tileSize;
+}
+
+void FarFieldRing::GenerateTile(const TileKey& key){
+    // One extra sample on every side, for the normals along the edges
+    int width = m_tileCells + 1;
+    int samples = width + 2;
+    float x0 = key.first * m_tileSize;
+    float z0 = key.second * m_tileSize;
+    std::vector<float> heights(samples * samples);
+    m_heightFunction(x0 - m_spacing, z0 - m_spacing, m_spacing, samples, samples, heights.data());
+
+    // Vertices are in world space, so every tile shares the model matrix
+    std::vector<float> positions, normals, colors;
+    positions.reserve(width * width * 3);
+    normals.reserve(width * width * 3);
+    colors.reserve(width * width * 3);
+    for (int y = 0; y < width; y++) {
+        for (int x = 0; x < width; x++) {
+            float height = heights[(x + 1) + (y + 1)*samples];
+            positions.push_back(x0 + x * m_spacing);
+            positions.push_back(height);
+            positions.push_back(z0 + y * m_spacing);
+
+            float dx = heights[(x + 2) + (y + 1)*samples] - heights[x + (y + 1)*samples];
+            float dz = heights[(x + 1) + (y + 2)*samples] - heights[(x + 1) + y*samples];
+            glm::vec3 normal = glm::normalize(glm::vec3(-dx, 2.0f * m_spacing, -dz));
+            normals.push_back(normal.x);
+            normals.push_back(normal.y);
+            normals.push_back(normal.z);
+
+            glm::vec3 color = m_colorFunction(height);
+            colors.push_back(color.r);
+            colors.push_back(color.g);
+            colors.push_back(color.b);
+        }
+    }
+
+    int slot = m_arena.Allocate();
+    m_arena.Upload(slot, positions.data(), normals.data(), colors.data());
+    m_tiles[key] = slot;
+}
+
+float FarFieldRing::NearestDistance(const TileKey& key, const glm::vec3& eye) const{
+    glm::vec2 min(key.first * m_tileSize, key.second * m_tileSize);
+    glm::vec2 eyeXZ(eye.x, eye.z);
+    glm::vec2 closest = glm::clamp(eyeXZ, min, min + glm::vec2(m_tileSize));
+    return glm::distance(eyeXZ, closest);
+}
+
+float FarFieldRing::FurthestDistance(const TileKey& key, const glm::vec3& eye) const{
+    glm::vec2 min(key.first * m_tileSize, key.second * m_tileSize);
+    glm::vec2 eyeXZ(eye.x, eye.z);
+    glm::vec2 furthest(eyeXZ.x < min.x + m_tileSize * 0.5f ? min.x + m_tileSize : min.x,
+                       eyeXZ.y < min.y + m_tileSize * 0.5f ? min.y + m_tileSize : min.y);
+    return glm::distance(eyeXZ, furthest);
+}
@@ -0,0 +1,70 @@
+#include "Fingerprint.hpp"
+
+#include <cstring>
+
+// 64 bit FNV-1a constants
+static const uint64_t FNV_OFFSET = 0xcbf29ce484222325ull;
+static const uint64_t FNV_PRIME = 0x100000001b3ull;
+
+Fingerprint::Fingerprint(){
+    m_hash = FNV_OFFSET;
+}
+
+void Fingerprint::AddBytes(const unsigned char* bytes, size_t count){
+    for (size_t i = 0; i < count; i++) {
+        m_hash ^= bytes[i];
+        m_hash *= FNV_PRIME;
+    }
+}
+
+Fingerprint& Fingerprint::Add(uint64_t value){
+    // Always little-endian, whatever the host byte order is
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+    AddBytes(bytes, 8);
+    return *this;
+}
+
+Fingerprint& Fingerprint::Add(int value){
+    return Add((uint64_t)(int64_t)value);
+}
+
+Fingerprint& Fingerprint::Add(float value){
+    // -0.0 and 0.0 generate the same terrain
+    if (value == 0.0f) {
+        value = 0.0f;
+    }
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return Add((uint64_t)bits);
+}
+
+Fingerprint& Fingerprint::Add(const std::string& value){
+    // The length keeps "ab"+"c" apart from "a"+"bc"
+    Add((uint64_t)value.size());
+    AddBytes((const unsigned char*)value.data(), value.size());
+    return *this;
+}
+
+Fingerprint& Fingerprint::Add(const std::vector<int>& values){
+    Add((uint64_t)values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        Add(values[i]);
+    }
+    return *this;
+}
+
+uint64_t Fingerprint::GetValue() const{
+    return m_hash;
+}
+
+std::string Fingerprint::ToString() const{
+    static const char digits[] = "0123456789abcdef";
+    std::string result(16, '0');
+    for (int i = 0; i < 16; i++) {
+        result[15 - i] = digits[(m_hash >> (4 * i)) & 0xF];
+    }
+    return result;
+}
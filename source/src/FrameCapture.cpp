@@ -0,0 +1,210 @@
+#include "FrameCapture.hpp"
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+FrameCapture::FrameCapture(int width, int height, int buffers, int maxQueued){
+    m_width = width;
+    m_height = height;
+    m_maxQueued = maxQueued > 0 ? maxQueued : 1;
+    m_format = PPM_FRAMES;
+    m_capturing = false;
+    m_frame = 0;
+    m_dropped = 0;
+    m_stop = false;
+    m_buffers.resize(buffers > 0 ? buffers : 1, 0);
+    m_bufferFrames.resize(m_buffers.size(), -1);
+}
+
+FrameCapture::~FrameCapture(){
+    Stop();
+}
+
+void FrameCapture::Log(const char* system, const char* message){
+    std::cout << "[" << system << "]" << message << "\n";
+}
+
+void FrameCapture::Start(Format format, const std::string& path){
+    Stop();
+    m_format = format;
+    m_path = path;
+
+    std::error_code error;
+    if (format == PPM_FRAMES) {
+        std::filesystem::create_directories(path, error);
+    } else {
+        m_video.open(path, std::ios::binary | std::ios::trunc);
+    }
+    if (error || (format == RAW_VIDEO && !m_video.is_open())) {
+        Log("FrameCapture", ("could not write to " + path + ", frames are not captured").c_str());
+        m_video.close();
+        return;
+    }
+
+    // Buffers only exist while capturing
+    glGenBuffers(m_buffers.size(), m_buffers.data());
+    for (int i = 0; i < m_buffers.size(); i++) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, m_width * m_height * 3, nullptr, GL_STREAM_READ);
+        m_bufferFrames[i] = -1;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_frame = 0;
+    m_dropped = 0;
+    m_stop = false;
+    m_capturing = true;
+    m_writer = std::thread(&FrameCapture::WriterLoop, this);
+}
+
+void FrameCapture::Stop(){
+    if (!m_capturing) {
+        return;
+    }
+    // The frames still in the ring, oldest first
+    for (int i = 0; i < m_buffers.size(); i++) {
+        Collect((m_frame + i) % m_buffers.size());
+    }
+    glDeleteBuffers(m_buffers.size(), m_buffers.data());
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_writer.join();
+    m_video.close();
+    m_capturing = false;
+
+    std::cout << "Captured " << m_frame - m_dropped << " frames to " << m_path;
+    if (m_dropped > 0) {
+        std::cout << ", " << m_dropped << " dropped while the writer was behind";
+    }
+    std::cout << std::endl;
+}
+
+bool FrameCapture::IsCapturing() const{
+    return m_capturing;
+}
+
+void FrameCapture::Capture(){
+    if (!m_capturing) {
+        return;
+    }
+    int buffer = m_frame % m_buffers.size();
+    Collect(buffer);
+
+    // Rows are read tightly packed, the copy happens on the GPU
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[buffer]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, (void*)0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_bufferFrames[buffer] = m_frame;
+    m_frame++;
+}
+
+void FrameCapture::Collect(int buffer){
+    int number = m_bufferFrames[buffer];
+    if (number < 0) {
+        return;
+    }
+    m_bufferFrames[buffer] = -1;
+
+    Frame frame;
+    frame.number = number;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queue.size() >= m_maxQueued) {
+            m_dropped++;
+            return;
+        }
+        if (!m_free.empty()) {
+            frame.pixels.swap(m_free.back());
+            m_free.pop_back();
+        }
+    }
+
+    size_t size = m_width * m_height * 3;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[buffer]);
+    void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (data) {
+        frame.pixels.resize(size);
+        std::memcpy(frame.pixels.data(), data, size);
+    }
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (!data) {
+        m_dropped++;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(frame));
+    }
+    m_wake.notify_one();
+}
+
+void FrameCapture::WriterLoop(){
+    while (true) {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+            // Everything queued is still written before stopping
+            if (m_queue.empty()) {
+                return;
+            }
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        Write(frame);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(std::move(frame.pixels));
+    }
+}
+
+void FrameCapture::Write(const Frame& frame){
+    int rowSize = m_width * 3;
+    // GL reads rows bottom up, images store them top down
+    if (m_format == RAW_VIDEO) {
+        for (int y = m_height - 1; y >= 0; y--) {
+            m_video.write((const char*)&frame.pixels[y * rowSize], rowSize);
+        }
+        return;
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "/frame%05d.ppm", frame.number);
+    std::ofstream file(m_path + name, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        Log("FrameCapture", ("could not write " + m_path + name).c_str());
+        return;
+    }
+    file << "P3\n# CREATOR: Terrain Generator\n" << m_width << " " << m_height << "\n255\n";
+
+    // One value per line, like the images in common/textures
+    std::string text;
+    text.reserve(rowSize * 4);
+    for (int y = m_height - 1; y >= 0; y--) {
+        text.clear();
+        const unsigned char* row = &frame.pixels[y * rowSize];
+        for (int i = 0; i < rowSize; i++) {
+            int value = row[i];
+            if (value >= 100) {
+                text += (char)('0' + value / 100);
+            }
+            if (value >= 10) {
+                text += (char)('0' + value / 10 % 10);
+            }
+            text += (char)('0' + value % 10);
+            text += '\n';
+        }
+        file.write(text.data(), text.size());
+    }
+}
@@ -0,0 +1,76 @@
+#include "FrameClock.hpp"
+
+#include <algorithm>
+#include <thread>
+
+// Frames longer than this (a stall or a breakpoint) only advance the
+// simulation by this much, instead of running a burst of updates
+static const double MAX_FRAME_SECONDS = 0.25;
+
+FrameClock::FrameClock(double step, int history){
+    m_step = step;
+    m_accumulator = 0.0;
+    m_started = false;
+    m_frameTimes.resize(history > 0 ? history : 1, 0.0);
+    m_next = 0;
+    m_count = 0;
+}
+
+void FrameClock::BeginFrame(){
+    Clock::time_point now = Clock::now();
+    // The first frame only starts the clock
+    if (!m_started) {
+        m_started = true;
+        m_frameStart = now;
+        return;
+    }
+    double seconds = std::chrono::duration<double>(now - m_frameStart).count();
+    m_frameStart = now;
+
+    m_frameTimes[m_next] = seconds * 1000.0;
+    m_next = (m_next + 1) % m_frameTimes.size();
+    m_count = std::min(m_count + 1, (int)m_frameTimes.size());
+
+    m_accumulator += std::min(seconds, MAX_FRAME_SECONDS);
+}
+
+bool FrameClock::Step(){
+    if (m_accumulator < m_step) {
+        return false;
+    }
+    m_accumulator -= m_step;
+    return true;
+}
+
+double FrameClock::GetStep() const{
+    return m_step;
+}
+
+float FrameClock::GetAlpha() const{
+    return (float)(m_accumulator / m_step);
+}
+
+void FrameClock::Pace(double maxFps){
+    if (maxFps <= 0.0) {
+        return;
+    }
+    Clock::time_point end = m_frameStart + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / maxFps));
+    std::this_thread::sleep_until(end);
+}
+
+FrameClock::Stats FrameClock::GetStats() const{
+    Stats stats = { m_count, 0.0, 0.0, 0.0, 0.0 };
+    if (m_count == 0) {
+        return stats;
+    }
+    std::vector<double> times(m_frameTimes.begin(), m_frameTimes.begin() + m_count);
+    std::sort(times.begin(), times.end());
+    for (int i = 0; i < times.size(); i++) {
+        stats.average += times[i];
+    }
+    stats.average /= times.size();
+    stats.best = times.front();
+    stats.worst = times.back();
+    stats.percentile99 = times[std::min((int)times.size() - 1, (int)(times.size() * 0.99))];
+    return stats;
+}
@@ -0,0 +1,85 @@
+#include "FrameUniforms.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+FrameUniforms::FrameUniforms(){
+    m_frame.projection = glm::mat4(1.0f);
+    m_frame.view = glm::mat4(1.0f);
+    m_frame.viewPos = glm::vec4(0.0f);
+    m_light.position = glm::vec4(0.0f);
+    m_light.ambient = glm::vec4(0.0f);
+    m_light.diffuse = glm::vec4(0.0f);
+    m_light.specular = glm::vec4(0.0f);
+    m_frameDirty = true;
+    m_lightDirty = true;
+    m_perspectiveParameters = glm::vec4(0.0f);
+    m_perspective = glm::mat4(1.0f);
+
+    glGenBuffers(1, &m_frameUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_frameUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameBlock), &m_frame, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BINDING, m_frameUBO);
+
+    glGenBuffers(1, &m_lightUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_lightUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), &m_light, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, LIGHT_BINDING, m_lightUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+FrameUniforms::~FrameUniforms(){
+    glDeleteBuffers(1, &m_frameUBO);
+    glDeleteBuffers(1, &m_lightUBO);
+}
+
+void FrameUniforms::Attach(Shader& shader) const{
+    shader.BindUniformBlock("FrameData", FRAME_BINDING);
+    shader.BindUniformBlock("LightData", LIGHT_BINDING);
+}
+
+const glm::mat4& FrameUniforms::SetPerspective(float fovy, float aspect, float nearPlane, float farPlane){
+    glm::vec4 parameters(fovy, aspect, nearPlane, farPlane);
+    if (parameters != m_perspectiveParameters) {
+        m_perspective = glm::perspective(fovy, aspect, nearPlane, farPlane);
+        m_perspectiveParameters = parameters;
+    }
+    SetProjection(m_perspective);
+    return m_perspective;
+}
+
+void FrameUniforms::SetProjection(const glm::mat4& projection){
+    if (projection != m_frame.projection) {
+        m_frame.projection = projection;
+        m_frameDirty = true;
+    }
+}
+
+void FrameUniforms::SetView(const glm::mat4& view, const glm::vec3& eye){
+    if (view != m_frame.view || glm::vec3(m_frame.viewPos) != eye) {
+        m_frame.view = view;
+        m_frame.viewPos = glm::vec4(eye, 1.0f);
+        m_frameDirty = true;
+    }
+}
+
+void FrameUniforms::SetLight(const glm::vec3& position, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular){
+    m_light.position = glm::vec4(position, 1.0f);
+    m_light.ambient = glm::vec4(ambient, 0.0f);
+    m_light.diffuse = glm::vec4(diffuse, 0.0f);
+    m_light.specular = glm::vec4(specular, 0.0f);
+    m_lightDirty = true;
+}
+
+void FrameUniforms::Upload(){
+    if (m_frameDirty) {
+        glBindBuffer(GL_UNIFORM_BUFFER, m_frameUBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameBlock), &m_frame);
+        m_frameDirty = false;
+    }
+    if (m_lightDirty) {
+        glBindBuffer(GL_UNIFORM_BUFFER, m_lightUBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightBlock), &m_light);
+        m_lightDirty = false;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,114 @@
+#include "Frustum.hpp"
+
+#include <cmath>
+
+#if defined(__SSE__)
+    #include <xmmintrin.h>
+#endif
+
+void BoxList::Resize(int count){
+    m_count = count;
+    int padded = (count + 3) & ~3;
+    // Padding boxes are empty and far away, so they are never visible
+    centerX.assign(padded, 1e30f);
+    centerY.assign(padded, 1e30f);
+    centerZ.assign(padded, 1e30f);
+    extentX.assign(padded, 0.0f);
+    extentY.assign(padded, 0.0f);
+    extentZ.assign(padded, 0.0f);
+}
+
+void BoxList::Set(int index, const glm::vec3& min, const glm::vec3& max){
+    glm::vec3 center = (min + max) * 0.5f;
+    glm::vec3 extent = (max - min) * 0.5f;
+    centerX[index] = center.x;
+    centerY[index] = center.y;
+    centerZ[index] = center.z;
+    extentX[index] = extent.x;
+    extentY[index] = extent.y;
+    extentZ[index] = extent.z;
+}
+
+int BoxList::Size() const{
+    return m_count;
+}
+
+Frustum::Frustum(const glm::mat4& viewProjection){
+    // Rows of the matrix, glm stores it by columns
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++) {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+
+    m_planes[0] = rows[3] + rows[0];    // Left
+    m_planes[1] = rows[3] - rows[0];    // Right
+    m_planes[2] = rows[3] + rows[1];    // Bottom
+    m_planes[3] = rows[3] - rows[1];    // Top
+    m_planes[4] = rows[3] + rows[2];    // Near
+    m_planes[5] = rows[3] - rows[2];    // Far
+
+    for (int i = 0; i < 6; i++) {
+        m_planes[i] /= glm::length(glm::vec3(m_planes[i]));
+    }
+}
+
+bool Frustum::Intersects(const glm::vec3& min, const glm::vec3& max) const{
+    glm::vec3 center = (min + max) * 0.5f;
+    glm::vec3 extent = (max - min) * 0.5f;
+    for (int i = 0; i < 6; i++) {
+        glm::vec3 normal = glm::vec3(m_planes[i]);
+        float distance = glm::dot(normal, center) + m_planes[i].w;
+        float radius = glm::dot(glm::abs(normal), extent);
+        if (distance < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int Frustum::Cull(const BoxList& boxes, std::vector<char>& visible) const{
+    int count = boxes.Size();
+    int visibleCount = 0;
+    visible.resize(count);
+
+    int i = 0;
+#if defined(__SSE__)
+    // Four boxes against one plane at a time. A box is outside as soon as
+    // its center is further behind a plane than its projected radius.
+    // The list is padded, so the last group can be loaded whole.
+    for (; i < count; i += 4) {
+        __m128 cx = _mm_loadu_ps(&boxes.centerX[i]);
+        __m128 cy = _mm_loadu_ps(&boxes.centerY[i]);
+        __m128 cz = _mm_loadu_ps(&boxes.centerZ[i]);
+        __m128 ex = _mm_loadu_ps(&boxes.extentX[i]);
+        __m128 ey = _mm_loadu_ps(&boxes.extentY[i]);
+        __m128 ez = _mm_loadu_ps(&boxes.extentZ[i]);
+        __m128 outside = _mm_setzero_ps();
+
+        for (int p = 0; p < 6; p++) {
+            const glm::vec4& plane = m_planes[p];
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)),
+                                                    _mm_mul_ps(cy, _mm_set1_ps(plane.y))),
+                                         _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)),
+                                                    _mm_set1_ps(plane.w)));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(std::fabs(plane.x))),
+                                                  _mm_mul_ps(ey, _mm_set1_ps(std::fabs(plane.y)))),
+                                       _mm_mul_ps(ez, _mm_set1_ps(std::fabs(plane.z))));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        int mask = _mm_movemask_ps(outside);
+        for (int j = 0; j < 4 && i + j < count; j++) {
+            visible[i + j] = !(mask & (1 << j));
+            visibleCount += visible[i + j];
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        glm::vec3 center(boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i]);
+        glm::vec3 extent(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]);
+        visible[i] = Intersects(center - extent, center + extent);
+        visibleCount += visible[i];
+    }
+    return visibleCount;
+}
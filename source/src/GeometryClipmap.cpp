@@ -0,0 +1,205 @@
+#include "GeometryClipmap.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+// Fraction of a level's half width, at its outer edge, over which
+// vertices morph into the grid of the next coarser level
+static const float MORPH_RATIO = 0.2f;
+
+// Rounds towards negative infinity
+static int floorDiv(int a, int b){
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+GeometryClipmap::GeometryClipmap(int levels, int size, float spacing, HeightFunction heightFunction){
+    m_size = size;
+    // One texel either side is kept for the normals and the morph
+    m_halfCells = m_size / 2 - 2;
+    m_spacing = spacing;
+    m_heightFunction = heightFunction;
+    m_scratch.resize(m_size * m_size);
+
+    for (int i = 0; i < levels; i++) {
+        Level level;
+        level.center = glm::ivec2(0);
+        level.origin = glm::ivec2(0);
+        level.valid = false;
+
+        // Repeat wrapping does the toroidal addressing for us
+        glGenTextures(1, &level.texture);
+        glBindTexture(GL_TEXTURE_2D, level.texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, m_size, m_size, 0, GL_RED, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        m_levels.push_back(level);
+    }
+
+    // Every level is drawn with the same grid of cell offsets from its center
+    std::vector<float> vertices;
+    std::vector<GLuint> indices;
+    int width = 2 * m_halfCells + 1;
+    for (int y = -m_halfCells; y <= m_halfCells; y++) {
+        for (int x = -m_halfCells; x <= m_halfCells; x++) {
+            vertices.push_back(x);
+            vertices.push_back(y);
+        }
+    }
+    // The whole grid, then the four rings. A finer level covers half as
+    // many of this level's cells, offset by 'ox' and 'oy' cells.
+    int footprint = m_halfCells / 2;
+    for (int ring = -1; ring < 4; ring++) {
+        if (ring >= 0) {
+            m_ringFirst[ring] = indices.size();
+        }
+        int ox = ring & 1;
+        int oy = ring >> 1 & 1;
+        for (int y = 0; y < width - 1; y++) {
+            for (int x = 0; x < width - 1; x++) {
+                int cellX = x - m_halfCells;
+                int cellY = y - m_halfCells;
+                if (ring >= 0 && cellX >= ox - footprint && cellX < ox + footprint
+                              && cellY >= oy - footprint && cellY < oy + footprint) {
+                    continue;
+                }
+                int pos = x + y*width;
+                indices.push_back(pos + width);
+                indices.push_back(pos);
+                indices.push_back(pos + width + 1);
+                indices.push_back(pos + 1);
+                indices.push_back(pos + 1 + width);
+                indices.push_back(pos);
+            }
+        }
+        if (ring < 0) {
+            m_indexCount = indices.size();
+        }
+    }
+    m_ringCount = m_ringFirst[1] - m_ringFirst[0];
+
+    glGenVertexArrays(1, &m_VAO);
+    glGenBuffers(1, &m_VBO);
+    glGenBuffers(1, &m_EBO);
+
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+}
+
+GeometryClipmap::~GeometryClipmap(){
+    for (int i = 0; i < m_levels.size(); i++) {
+        glDeleteTextures(1, &m_levels[i].texture);
+    }
+    glDeleteVertexArrays(1, &m_VAO);
+    glDeleteBuffers(1, &m_VBO);
+    glDeleteBuffers(1, &m_EBO);
+}
+
+float GeometryClipmap::GetSpacing(int level) const{
+    return m_spacing * (1 << level);
+}
+
+float GeometryClipmap::GetViewDistance() const{
+    return m_halfCells * GetSpacing(m_levels.size() - 1);
+}
+
+void GeometryClipmap::Invalidate(){
+    for (int i = 0; i < m_levels.size(); i++) {
+        m_levels[i].valid = false;
+    }
+}
+
+void GeometryClipmap::Update(const glm::vec3& eye){
+    for (int i = 0; i < m_levels.size(); i++) {
+        Level& level = m_levels[i];
+        float spacing = GetSpacing(i);
+
+        // Centers snap to every other vertex, so the edges of a level
+        // always land on vertices of the next coarser one
+        glm::ivec2 center(2 * (int)std::floor(eye.x / (2.0f * spacing)),
+                          2 * (int)std::floor(eye.z / (2.0f * spacing)));
+        glm::ivec2 origin = center - glm::ivec2(m_size / 2);
+        glm::ivec2 moved = origin - level.origin;
+        level.center = center;
+
+        if (!level.valid || std::abs(moved.x) >= m_size || std::abs(moved.y) >= m_size) {
+            UpdateRegion(i, origin.x, origin.y, m_size, m_size);
+        } else {
+            // The L-shaped strip that came into view: whole columns first,
+            // then whole rows
+            if (moved.x > 0) {
+                UpdateRegion(i, level.origin.x + m_size, origin.y, moved.x, m_size);
+            } else if (moved.x < 0) {
+                UpdateRegion(i, origin.x, origin.y, -moved.x, m_size);
+            }
+            if (moved.y > 0) {
+                UpdateRegion(i, origin.x, level.origin.y + m_size, m_size, moved.y);
+            } else if (moved.y < 0) {
+                UpdateRegion(i, origin.x, origin.y, m_size, -moved.y);
+            }
+        }
+        level.origin = origin;
+        level.valid = true;
+    }
+}
+
+void GeometryClipmap::UpdateRegion(int level, int x, int y, int width, int height){
+    float spacing = GetSpacing(level);
+    glBindTexture(GL_TEXTURE_2D, m_levels[level].texture);
+
+    // A block that crosses the edge of the texture is split in up to four
+    int doneY = 0;
+    while (doneY < height) {
+        int texelY = (y + doneY) - floorDiv(y + doneY, m_size) * m_size;
+        int rows = std::min(height - doneY, m_size - texelY);
+
+        int doneX = 0;
+        while (doneX < width) {
+            int texelX = (x + doneX) - floorDiv(x + doneX, m_size) * m_size;
+            int columns = std::min(width - doneX, m_size - texelX);
+
+            m_heightFunction((x + doneX) * spacing, (y + doneY) * spacing, spacing, columns, rows, &m_scratch[0]);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, texelX, texelY, columns, rows, GL_RED, GL_FLOAT, &m_scratch[0]);
+            doneX += columns;
+        }
+        doneY += rows;
+    }
+}
+
+void GeometryClipmap::Render(Shader& shader) const{
+    shader.SetUniform1i("u_Heightmap", 0);
+    shader.SetUniform1f("u_TextureSize", (float)m_size);
+    shader.SetUniform1f("u_HalfCells", (float)m_halfCells);
+    shader.SetUniform1f("u_MorphCells", m_halfCells * MORPH_RATIO);
+    Shader::Uniform<float> spacingUniform = shader.GetUniform<float>("u_Spacing");
+    Shader::Uniform<glm::vec2> levelCenter = shader.GetUniform<glm::vec2>("u_LevelCenter");
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(m_VAO);
+    for (int i = 0; i < m_levels.size(); i++) {
+        const Level& level = m_levels[i];
+        float spacing = GetSpacing(i);
+
+        spacingUniform.Set(spacing);
+        levelCenter.Set(glm::vec2(level.center));
+        glBindTexture(GL_TEXTURE_2D, level.texture);
+        if (i == 0) {
+            glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0);
+            continue;
+        }
+
+        // The ring around where the finer level is drawn, whose center is
+        // in this level's cells half its own
+        glm::ivec2 offset = m_levels[i - 1].center / 2 - level.center;
+        int ring = std::min(std::max(offset.x, 0), 1) + 2 * std::min(std::max(offset.y, 0), 1);
+        glDrawElements(GL_TRIANGLES, m_ringCount, GL_UNSIGNED_INT, (void*)(m_ringFirst[ring] * sizeof(GLuint)));
+    }
+}
@@ -0,0 +1,326 @@
+#include "HeightCodec.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+// Stream layout: magic, width, height, minimum height, height scale, then bits
+static const uint32_t CODEC_MAGIC = 0x43485450; // "PTHC"
+// Same header, then the rounded heights as raw floats
+static const uint32_t RAW_MAGIC = 0x52485450; // "PTHR"
+static const size_t HEADER_SIZE = sizeof(uint32_t) + 2 * sizeof(uint16_t) + 2 * sizeof(float);
+// Residuals are Rice coded in blocks that share one parameter
+static const int BLOCK_SIZE = 32;
+// Quotients this large are escaped and stored as raw 16 bit values,
+// it also bounds how many ones the reader looks for
+static const int ESCAPE_LENGTH = 24;
+
+// Packs bits least significant first into a byte vector
+struct BitWriter{
+    std::vector<char>& out;
+    uint64_t bits = 0;
+    int count = 0;
+
+    BitWriter(std::vector<char>& _out) : out(_out) {}
+
+    void Write(uint32_t value, int n){
+        bits |= (uint64_t)value << count;
+        count += n;
+        while (count >= 8) {
+            out.push_back((char)(bits & 0xFF));
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+
+    void WriteOnes(int n){
+        while (n > 16) {
+            Write(0xFFFF, 16);
+            n -= 16;
+        }
+        Write((1u << n) - 1, n);
+    }
+
+    void Flush(){
+        if (count > 0) {
+            out.push_back((char)(bits & 0xFF));
+        }
+        bits = 0;
+        count = 0;
+    }
+};
+
+// Reads bits written by BitWriter, past the end it only sees zeros and
+// Overrun tells that the stream was too short
+struct BitReader{
+    const unsigned char* data;
+    size_t size;
+    size_t pos = 0;
+    uint64_t bits = 0;
+    int count = 0;
+
+    BitReader(const char* _data, size_t _size) : data((const unsigned char*)_data), size(_size) {}
+
+    void Refill(){
+        while (count <= 56) {
+            uint64_t byte = pos < size ? data[pos] : 0;
+            pos++;
+            bits |= byte << count;
+            count += 8;
+        }
+    }
+
+    uint32_t Read(int n){
+        Refill();
+        uint32_t value = (uint32_t)(bits & ((1ull << n) - 1));
+        bits >>= n;
+        count -= n;
+        return value;
+    }
+
+    // Counts (and consumes) ones up to the first zero, at most 'limit',
+    // which has to stay below the 57 bits a refill leaves
+    int ReadUnary(int limit){
+        Refill();
+        // 64 ones have no zero for ctz to find
+        uint64_t zeros = ~bits;
+        int ones = zeros != 0 ? __builtin_ctzll(zeros) : 64;
+        if (ones >= limit) {
+            bits >>= limit;
+            count -= limit;
+            return limit;
+        }
+        bits >>= ones + 1;
+        count -= ones + 1;
+        return ones;
+    }
+
+    // Whether more bits were consumed than the stream holds
+    bool Overrun() const{
+        return pos * 8 - count > size * 8;
+    }
+};
+
+static uint16_t zigzag(uint16_t value){
+    int16_t s = (int16_t)value;
+    return (uint16_t)((s << 1) ^ (s >> 15));
+}
+
+static uint16_t unzigzag(uint16_t value){
+    return (uint16_t)((value >> 1) ^ (uint16_t)-(int16_t)(value & 1));
+}
+
+// Picks the Rice parameter that roughly matches the mean of a block
+static int riceParameter(const uint16_t* values, int n){
+    uint32_t sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += values[i];
+    }
+    int k = 0;
+    while (k < 15 && ((uint32_t)n << (k + 1)) <= sum) {
+        k++;
+    }
+    return k;
+}
+
+std::vector<char> HeightCodec::Encode(const float* heights, int width, int height, float step){
+    std::vector<char> out(HEADER_SIZE);
+    int n = width * height;
+
+    float minHeight = heights[0];
+    float maxHeight = heights[0];
+    for (int i = 1; i < n; i++) {
+        minHeight = std::min(minHeight, heights[i]);
+        maxHeight = std::max(maxHeight, heights[i]);
+    }
+    float scale = step;
+
+    // Round every height on its own, not relative to the chunk minimum, so
+    // neighbours agree on the samples they share. With a power of two
+    // scale, minHeight + quantized * scale is exact when decoding.
+    float inverse = 1.0f / scale;
+    long base = (long)std::floor(minHeight * inverse);
+    minHeight = base * scale;
+    uint16_t size[2] = { (uint16_t)width, (uint16_t)height };
+
+    // Too wide a range for 16 bit offsets, a coarser step would round
+    // this chunk differently from its neighbours
+    if ((maxHeight - minHeight) * inverse > 65534.0f) {
+        uint32_t magic = RAW_MAGIC;
+        std::memcpy(&out[0], &magic, sizeof(magic));
+        std::memcpy(&out[4], size, sizeof(size));
+        std::memcpy(&out[8], &minHeight, sizeof(float));
+        std::memcpy(&out[12], &scale, sizeof(float));
+        out.resize(HEADER_SIZE + n * sizeof(float));
+        for (int i = 0; i < n; i++) {
+            float rounded = std::lround(heights[i] * inverse) * scale;
+            std::memcpy(&out[HEADER_SIZE + i * sizeof(float)], &rounded, sizeof(float));
+        }
+        return out;
+    }
+
+    std::vector<uint16_t> quantized(n);
+    for (int i = 0; i < n; i++) {
+        quantized[i] = (uint16_t)(std::lround(heights[i] * inverse) - base);
+    }
+
+    // Gradient prediction: the vertical delta of a sample minus the vertical
+    // delta of its left neighbour. All arithmetic wraps at 16 bits.
+    std::vector<uint16_t> residuals(n);
+    for (int y = 0; y < height; y++) {
+        uint16_t leftDelta = 0;
+        for (int x = 0; x < width; x++) {
+            uint16_t above = y > 0 ? quantized[x + (y-1)*width] : 0;
+            uint16_t delta = quantized[x + y*width] - above;
+            residuals[x + y*width] = zigzag(delta - leftDelta);
+            leftDelta = delta;
+        }
+    }
+
+    BitWriter writer(out);
+    for (int start = 0; start < n; start += BLOCK_SIZE) {
+        int count = std::min(BLOCK_SIZE, n - start);
+        int k = riceParameter(&residuals[start], count);
+        writer.Write(k, 4);
+        for (int i = start; i < start + count; i++) {
+            uint32_t quotient = residuals[i] >> k;
+            if (quotient < ESCAPE_LENGTH) {
+                writer.WriteOnes(quotient);
+                writer.Write(0, 1);
+                writer.Write(residuals[i] & ((1u << k) - 1), k);
+            } else {
+                writer.WriteOnes(ESCAPE_LENGTH);
+                writer.Write(residuals[i], 16);
+            }
+        }
+    }
+    writer.Flush();
+
+    uint32_t magic = CODEC_MAGIC;
+    std::memcpy(&out[0], &magic, sizeof(magic));
+    std::memcpy(&out[4], size, sizeof(size));
+    std::memcpy(&out[8], &minHeight, sizeof(float));
+    std::memcpy(&out[12], &scale, sizeof(float));
+    return out;
+}
+
+bool HeightCodec::GetSize(const char* data, size_t size, int& width, int& height){
+    if (size < HEADER_SIZE) {
+        return false;
+    }
+    uint32_t magic;
+    uint16_t dimensions[2];
+    std::memcpy(&magic, data, sizeof(magic));
+    std::memcpy(dimensions, data + 4, sizeof(dimensions));
+    if (magic != CODEC_MAGIC && magic != RAW_MAGIC) {
+        return false;
+    }
+    width = dimensions[0];
+    height = dimensions[1];
+    return true;
+}
+
+// Rebuilds one row of samples from its residuals and the row above.
+// The running sum of the residuals is the vertical delta of each sample.
+static void reconstructRow(const uint16_t* residuals, const uint16_t* above, uint16_t* row, int width){
+    int x = 0;
+    uint16_t delta = 0;
+#if defined(__SSE2__)
+    __m128i carry = _mm_setzero_si128();
+    for (; x + 8 <= width; x += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(residuals + x));
+        // Prefix sum over the 8 lanes
+        v = _mm_add_epi16(v, _mm_slli_si128(v, 2));
+        v = _mm_add_epi16(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi16(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi16(v, carry);
+        // Broadcast the last lane as the carry into the next 8
+        carry = _mm_shufflehi_epi16(v, 0xFF);
+        carry = _mm_unpackhi_epi64(carry, carry);
+
+        __m128i up = above ? _mm_loadu_si128((const __m128i*)(above + x)) : _mm_setzero_si128();
+        _mm_storeu_si128((__m128i*)(row + x), _mm_add_epi16(v, up));
+    }
+    delta = (uint16_t)_mm_extract_epi16(carry, 0);
+#endif
+    for (; x < width; x++) {
+        delta += residuals[x];
+        row[x] = delta + (above ? above[x] : 0);
+    }
+}
+
+// Turns quantized samples back into heights
+static void dequantize(const uint16_t* quantized, float* out, int n, float minHeight, float scale){
+    int i = 0;
+#if defined(__SSE2__)
+    __m128 base = _mm_set1_ps(minHeight);
+    __m128 step = _mm_set1_ps(scale);
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(quantized + i));
+        __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+        __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero));
+        _mm_storeu_ps(out + i, _mm_add_ps(base, _mm_mul_ps(lo, step)));
+        _mm_storeu_ps(out + i + 4, _mm_add_ps(base, _mm_mul_ps(hi, step)));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = minHeight + quantized[i] * scale;
+    }
+}
+
+bool HeightCodec::Decode(const char* data, size_t size, std::vector<float>& out){
+    int width, height;
+    if (!GetSize(data, size, width, height)) {
+        return false;
+    }
+    float minHeight, scale;
+    std::memcpy(&minHeight, data + 8, sizeof(float));
+    std::memcpy(&scale, data + 12, sizeof(float));
+
+    int n = width * height;
+    uint32_t magic;
+    std::memcpy(&magic, data, sizeof(magic));
+    if (magic == RAW_MAGIC) {
+        if (size != HEADER_SIZE + n * sizeof(float)) {
+            return false;
+        }
+        out.resize(n);
+        std::memcpy(&out[0], data + HEADER_SIZE, n * sizeof(float));
+        return true;
+    }
+    std::vector<uint16_t> residuals(n);
+    BitReader reader(data + HEADER_SIZE, size - HEADER_SIZE);
+    for (int start = 0; start < n; start += BLOCK_SIZE) {
+        int count = std::min(BLOCK_SIZE, n - start);
+        int k = reader.Read(4);
+        for (int i = start; i < start + count; i++) {
+            int quotient = reader.ReadUnary(ESCAPE_LENGTH);
+            uint16_t value;
+            if (quotient < ESCAPE_LENGTH) {
+                value = (uint16_t)((quotient << k) | reader.Read(k));
+            } else {
+                value = (uint16_t)reader.Read(16);
+            }
+            residuals[i] = unzigzag(value);
+        }
+        // A truncated stream stops here instead of decoding zeros
+        if (reader.Overrun()) {
+            return false;
+        }
+    }
+
+    std::vector<uint16_t> quantized(n);
+    for (int y = 0; y < height; y++) {
+        reconstructRow(&residuals[y*width], y > 0 ? &quantized[(y-1)*width] : nullptr, &quantized[y*width], width);
+    }
+
+    out.resize(n);
+    dequantize(&quantized[0], &out[0], n, minHeight, scale);
+    return true;
+}
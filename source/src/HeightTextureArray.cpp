@@ -0,0 +1,61 @@
+#include "HeightTextureArray.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+HeightTextureArray::HeightTextureArray(int size, int layers){
+    m_size = size;
+    m_minHeight = 0.0f;
+    m_heightRange = 1.0f;
+    m_samples.resize(size * size);
+
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R16, size, size, layers, 0, GL_RED, GL_UNSIGNED_SHORT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+HeightTextureArray::~HeightTextureArray(){
+    glDeleteTextures(1, &m_texture);
+}
+
+void HeightTextureArray::SetRange(float minHeight, float maxHeight){
+    m_minHeight = minHeight;
+    m_heightRange = std::max(maxHeight - minHeight, 1e-6f);
+}
+
+void HeightTextureArray::Upload(int layer, const float* heights){
+    float scale = 65535.0f / m_heightRange;
+    for (int i = 0; i < m_size * m_size; i++) {
+        float sample = std::min(std::max((heights[i] - m_minHeight) * scale, 0.0f), 65535.0f);
+        m_samples[i] = (uint16_t)std::lround(sample);
+    }
+
+    // Rows of an odd number of samples are not 4 byte aligned
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, m_size, m_size, 1, GL_RED, GL_UNSIGNED_SHORT, &m_samples[0]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void HeightTextureArray::Bind(GLenum textureUnit) const{
+    glActiveTexture(textureUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+}
+
+int HeightTextureArray::GetSize() const{
+    return m_size;
+}
+
+float HeightTextureArray::GetMinHeight() const{
+    return m_minHeight;
+}
+
+float HeightTextureArray::GetHeightRange() const{
+    return m_heightRange;
+}
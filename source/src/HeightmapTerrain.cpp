@@ -0,0 +1,77 @@
+#include "HeightmapTerrain.hpp"
+
+HeightmapTerrain::HeightmapTerrain(int chunkCells){
+    m_chunkCells = chunkCells;
+
+    // Grid points, in cells from the chunk's first vertex
+    std::vector<float> vertices;
+    std::vector<GLuint> indices;
+    int width = chunkCells + 1;
+    for (int y = 0; y < width; y++) {
+        for (int x = 0; x < width; x++) {
+            vertices.push_back(x);
+            vertices.push_back(y);
+        }
+    }
+    // Same winding as the chunk meshes
+    for (int y = 0; y < chunkCells; y++) {
+        for (int x = 0; x < chunkCells; x++) {
+            int pos = x + y*width;
+            indices.push_back(pos + width);
+            indices.push_back(pos);
+            indices.push_back(pos + width + 1);
+            indices.push_back(pos + 1);
+            indices.push_back(pos + width + 1);
+            indices.push_back(pos);
+        }
+    }
+    m_indexCount = indices.size();
+
+    glGenVertexArrays(1, &m_VAO);
+    glGenBuffers(1, &m_VBO);
+    glGenBuffers(1, &m_EBO);
+    glGenBuffers(1, &m_instanceVBO);
+
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+    glVertexAttribPointer(CHUNK, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glVertexAttribDivisor(CHUNK, 1);
+    glEnableVertexAttribArray(CHUNK);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+}
+
+HeightmapTerrain::~HeightmapTerrain(){
+    glDeleteVertexArrays(1, &m_VAO);
+    glDeleteBuffers(1, &m_VBO);
+    glDeleteBuffers(1, &m_EBO);
+    glDeleteBuffers(1, &m_instanceVBO);
+}
+
+void HeightmapTerrain::Bind(Shader& shader, const HeightTextureArray& heights) const{
+    heights.Bind(GL_TEXTURE0);
+    shader.SetUniform1i("u_Heights", 0);
+    shader.SetUniform1f("u_HeightMin", heights.GetMinHeight());
+    shader.SetUniform1f("u_HeightRange", heights.GetHeightRange());
+    shader.SetUniform1i("u_ChunkCells", m_chunkCells);
+    glBindVertexArray(m_VAO);
+}
+
+void HeightmapTerrain::Draw(const std::vector<glm::vec4>& chunks) const{
+    if (chunks.empty()) {
+        return;
+    }
+    // The instances change every frame, a fresh buffer each time keeps
+    // the driver from waiting on the previous frame's draw
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, chunks.size() * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, chunks.size() * sizeof(glm::vec4), chunks.data());
+    glDrawElementsInstanced(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0, chunks.size());
+}
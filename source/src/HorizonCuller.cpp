@@ -0,0 +1,137 @@
+#include "HorizonCuller.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE__)
+    #include <xmmintrin.h>
+#endif
+
+static const float TWO_PI = 6.28318530718f;
+
+HorizonCuller::HorizonCuller(int bins){
+    m_bins = bins;
+    m_horizon.resize(bins);
+}
+
+void HorizonCuller::Begin(const glm::vec3& eye){
+    m_eye = eye;
+    // Nothing hides anything yet
+    std::fill(m_horizon.begin(), m_horizon.end(), -INFINITY);
+}
+
+bool HorizonCuller::Project(const glm::vec3& min, const glm::vec3& max, float& firstBin, float& lastBin,
+                            float& nearest, float& furthest) const{
+    glm::vec2 eye(m_eye.x, m_eye.z);
+    glm::vec2 boxMin(min.x, min.z);
+    glm::vec2 boxMax(max.x, max.z);
+
+    nearest = glm::distance(eye, glm::clamp(eye, boxMin, boxMax));
+    if (nearest < 1e-3f) {
+        return false;
+    }
+
+    // Seen from outside, the box covers less than half the circle, so the
+    // corners can be measured from the direction of its center
+    glm::vec2 center = (boxMin + boxMax) * 0.5f - eye;
+    float centerAngle = std::atan2(center.y, center.x);
+    float minAngle = 0.0f;
+    float maxAngle = 0.0f;
+    furthest = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        glm::vec2 corner = glm::vec2(i & 1 ? boxMax.x : boxMin.x, i & 2 ? boxMax.y : boxMin.y) - eye;
+        float angle = std::atan2(corner.y, corner.x) - centerAngle;
+        if (angle > TWO_PI / 2) {
+            angle -= TWO_PI;
+        } else if (angle < -TWO_PI / 2) {
+            angle += TWO_PI;
+        }
+        minAngle = std::min(minAngle, angle);
+        maxAngle = std::max(maxAngle, angle);
+        furthest = std::max(furthest, glm::length(corner));
+    }
+
+    firstBin = (centerAngle + minAngle) / TWO_PI * m_bins;
+    lastBin = (centerAngle + maxAngle) / TWO_PI * m_bins;
+    return true;
+}
+
+bool HorizonCuller::IsOccluded(const glm::vec3& min, const glm::vec3& max) const{
+    float firstBin, lastBin, nearest, furthest;
+    if (!Project(min, max, firstBin, lastBin, nearest, furthest)) {
+        return false;
+    }
+
+    // The highest the box can appear is its top at the distance that
+    // makes it steepest, and it has to stay below every bin it touches
+    float height = max.y - m_eye.y;
+    float elevation = height / (height >= 0.0f ? nearest : furthest);
+
+    int first = (int)std::floor(firstBin);
+    int last = (int)std::floor(lastBin) + 1;
+    int wrap = (int)std::floor((float)first / m_bins) * m_bins;
+    first -= wrap;
+    last -= wrap;
+    if (last > m_bins) {
+        return !AboveHorizon(first, m_bins, elevation) && !AboveHorizon(0, last - m_bins, elevation);
+    }
+    return !AboveHorizon(first, last, elevation);
+}
+
+void HorizonCuller::AddOccluder(const glm::vec3& min, const glm::vec3& max){
+    float firstBin, lastBin, nearest, furthest;
+    if (!Project(min, max, firstBin, lastBin, nearest, furthest)) {
+        return;
+    }
+
+    // The lowest the solid part can appear, and only in the bins it
+    // covers completely
+    float height = max.y - m_eye.y;
+    float elevation = height / (height >= 0.0f ? furthest : nearest);
+
+    int first = (int)std::ceil(firstBin);
+    int last = (int)std::floor(lastBin);
+    if (last <= first) {
+        return;
+    }
+    int wrap = (int)std::floor((float)first / m_bins) * m_bins;
+    first -= wrap;
+    last -= wrap;
+    if (last > m_bins) {
+        RaiseHorizon(first, m_bins, elevation);
+        RaiseHorizon(0, last - m_bins, elevation);
+    } else {
+        RaiseHorizon(first, last, elevation);
+    }
+}
+
+bool HorizonCuller::AboveHorizon(int first, int last, float elevation) const{
+    int i = first;
+#if defined(__SSE__)
+    __m128 value = _mm_set1_ps(elevation);
+    for (; i + 4 <= last; i += 4) {
+        if (_mm_movemask_ps(_mm_cmpgt_ps(value, _mm_loadu_ps(&m_horizon[i]))) != 0) {
+            return true;
+        }
+    }
+#endif
+    for (; i < last; i++) {
+        if (elevation > m_horizon[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void HorizonCuller::RaiseHorizon(int first, int last, float elevation){
+    int i = first;
+#if defined(__SSE__)
+    __m128 value = _mm_set1_ps(elevation);
+    for (; i + 4 <= last; i += 4) {
+        _mm_storeu_ps(&m_horizon[i], _mm_max_ps(value, _mm_loadu_ps(&m_horizon[i])));
+    }
+#endif
+    for (; i < last; i++) {
+        m_horizon[i] = std::max(m_horizon[i], elevation);
+    }
+}
@@ -0,0 +1,260 @@
+#include "OcclusionRasterizer.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+OcclusionRasterizer::OcclusionRasterizer(int width, int height, int threads){
+    m_width = width;
+    m_height = height;
+    m_bands = std::max(threads, 1);
+    m_frame = 0;
+    m_pending = 0;
+    m_stop = false;
+
+    glm::ivec2 size(width, height);
+    while (true) {
+        m_levelSizes.push_back(size);
+        m_levels.push_back(std::vector<float>(size.x * size.y, 1.0f));
+        if (size.x == 1 && size.y == 1) {
+            break;
+        }
+        size = glm::max((size + 1) / 2, glm::ivec2(1));
+    }
+
+    // The calling thread fills the first band itself
+    for (int band = 1; band < m_bands; band++) {
+        m_workers.push_back(std::thread(&OcclusionRasterizer::WorkerLoop, this, band));
+    }
+}
+
+OcclusionRasterizer::~OcclusionRasterizer(){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+    for (int i = 0; i < m_workers.size(); i++) {
+        m_workers[i].join();
+    }
+}
+
+void OcclusionRasterizer::Begin(const glm::mat4& viewProjection){
+    m_viewProjection = viewProjection;
+    m_triangles.clear();
+    std::fill(m_levels[0].begin(), m_levels[0].end(), 1.0f);
+}
+
+void OcclusionRasterizer::AddOccluder(const std::vector<glm::vec3>& vertices, const std::vector<int>& indices){
+    std::vector<glm::vec4> clip(vertices.size());
+    for (int i = 0; i < vertices.size(); i++) {
+        clip[i] = m_viewProjection * glm::vec4(vertices[i], 1.0f);
+    }
+
+    for (int i = 0; i + 2 < indices.size(); i += 3) {
+        Triangle triangle;
+        bool clipped = false;
+        for (int j = 0; j < 3; j++) {
+            const glm::vec4& v = clip[indices[i + j]];
+            // Not clipping against the near plane only loses occlusion
+            if (v.z < -v.w || v.w <= 0.0f) {
+                clipped = true;
+                break;
+            }
+            triangle.v[j] = glm::vec3((v.x / v.w * 0.5f + 0.5f) * m_width,
+                                      (v.y / v.w * 0.5f + 0.5f) * m_height,
+                                      v.z / v.w * 0.5f + 0.5f);
+        }
+        if (!clipped) {
+            m_triangles.push_back(triangle);
+        }
+    }
+}
+
+void OcclusionRasterizer::Rasterize(){
+    if (m_bands > 1) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_frame++;
+        m_pending = m_bands - 1;
+    }
+    m_start.notify_all();
+
+    RasterizeBand(0, m_height / m_bands);
+
+    if (m_bands > 1) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_pending == 0; });
+    }
+    BuildPyramid();
+}
+
+void OcclusionRasterizer::WorkerLoop(int band){
+    int seenFrame = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [this, seenFrame]() { return m_stop || m_frame != seenFrame; });
+            if (m_stop) {
+                return;
+            }
+            seenFrame = m_frame;
+        }
+
+        RasterizeBand(band * m_height / m_bands, (band + 1) * m_height / m_bands);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_pending == 0) {
+            m_done.notify_one();
+        }
+    }
+}
+
+void OcclusionRasterizer::RasterizeBand(int firstRow, int lastRow){
+    for (int i = 0; i < m_triangles.size(); i++) {
+        RasterizeTriangle(m_triangles[i], firstRow, lastRow);
+    }
+}
+
+void OcclusionRasterizer::RasterizeTriangle(const Triangle& triangle, int firstRow, int lastRow){
+    glm::vec3 a = triangle.v[0];
+    glm::vec3 b = triangle.v[1];
+    glm::vec3 c = triangle.v[2];
+
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (std::fabs(area) < 1e-6f) {
+        return;
+    }
+    // Both windings are solid
+    if (area < 0) {
+        std::swap(b, c);
+        area = -area;
+    }
+
+    int minX = std::max((int)std::floor(std::min(a.x, std::min(b.x, c.x))), 0);
+    int maxX = std::min((int)std::ceil(std::max(a.x, std::max(b.x, c.x))), m_width - 1);
+    int minY = std::max((int)std::floor(std::min(a.y, std::min(b.y, c.y))), firstRow);
+    int maxY = std::min((int)std::ceil(std::max(a.y, std::max(b.y, c.y))), lastRow - 1);
+    if (minX > maxX || minY > maxY) {
+        return;
+    }
+
+    // Edge functions, positive inside, sampled at pixel centers. Pixels on
+    // an edge shared by two triangles are drawn by both, so there are no gaps.
+    glm::vec3 from[3] = { a, b, c };
+    glm::vec3 to[3] = { b, c, a };
+    float stepX[3], stepY[3], start[3];
+    float px = minX + 0.5f;
+    float py = minY + 0.5f;
+    for (int e = 0; e < 3; e++) {
+        stepX[e] = -(to[e].y - from[e].y);
+        stepY[e] = to[e].x - from[e].x;
+        start[e] = stepY[e] * (py - from[e].y) + stepX[e] * (px - from[e].x);
+    }
+
+    // Depth plane, moved to the furthest point of each pixel
+    float zx = ((b.z - a.z) * (c.y - a.y) - (c.z - a.z) * (b.y - a.y)) / area;
+    float zy = ((c.z - a.z) * (b.x - a.x) - (b.z - a.z) * (c.x - a.x)) / area;
+    float zStart = a.z + zx * (px - a.x) + zy * (py - a.y) + 0.5f * (std::fabs(zx) + std::fabs(zy));
+    float zFar = std::max(a.z, std::max(b.z, c.z));
+
+    std::vector<float>& depth = m_levels[0];
+    for (int y = minY; y <= maxY; y++) {
+        float dy = y - minY;
+        float e0 = start[0] + stepY[0] * dy;
+        float e1 = start[1] + stepY[1] * dy;
+        float e2 = start[2] + stepY[2] * dy;
+        float z = zStart + zy * dy;
+        for (int x = minX; x <= maxX; x++) {
+            if (e0 >= 0 && e1 >= 0 && e2 >= 0) {
+                float& d = depth[x + y*m_width];
+                d = std::min(d, std::min(z, zFar));
+            }
+            e0 += stepX[0];
+            e1 += stepX[1];
+            e2 += stepX[2];
+            z += zx;
+        }
+    }
+}
+
+void OcclusionRasterizer::BuildPyramid(){
+    // Pixels along an outline are only partly covered, so every pixel
+    // takes the furthest depth of its neighbours
+    std::vector<float>& depth = m_levels[0];
+    m_dilated.resize(depth.size());
+    for (int y = 0; y < m_height; y++) {
+        for (int x = 0; x < m_width; x++) {
+            float furthest = 0.0f;
+            for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, m_height - 1); ny++) {
+                for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, m_width - 1); nx++) {
+                    furthest = std::max(furthest, depth[nx + ny*m_width]);
+                }
+            }
+            m_dilated[x + y*m_width] = furthest;
+        }
+    }
+    depth.swap(m_dilated);
+
+    for (int level = 1; level < m_levels.size(); level++) {
+        const std::vector<float>& finer = m_levels[level - 1];
+        std::vector<float>& coarser = m_levels[level];
+        glm::ivec2 finerSize = m_levelSizes[level - 1];
+        glm::ivec2 size = m_levelSizes[level];
+
+        for (int y = 0; y < size.y; y++) {
+            int y0 = 2 * y;
+            int y1 = std::min(2 * y + 1, finerSize.y - 1);
+            for (int x = 0; x < size.x; x++) {
+                int x0 = 2 * x;
+                int x1 = std::min(2 * x + 1, finerSize.x - 1);
+                coarser[x + y*size.x] = std::max(std::max(finer[x0 + y0*finerSize.x], finer[x1 + y0*finerSize.x]),
+                                                 std::max(finer[x0 + y1*finerSize.x], finer[x1 + y1*finerSize.x]));
+            }
+        }
+    }
+}
+
+bool OcclusionRasterizer::IsOccluded(const glm::vec3& min, const glm::vec3& max) const{
+    glm::vec2 rectMin(INFINITY);
+    glm::vec2 rectMax(-INFINITY);
+    float nearest = INFINITY;
+    for (int i = 0; i < 8; i++) {
+        glm::vec3 corner(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+        glm::vec4 v = m_viewProjection * glm::vec4(corner, 1.0f);
+        // Reaching past the near plane, it can not be behind anything
+        if (v.z < -v.w || v.w <= 0.0f) {
+            return false;
+        }
+        glm::vec2 screen((v.x / v.w * 0.5f + 0.5f) * m_width, (v.y / v.w * 0.5f + 0.5f) * m_height);
+        rectMin = glm::min(rectMin, screen);
+        rectMax = glm::max(rectMax, screen);
+        nearest = std::min(nearest, v.z / v.w * 0.5f + 0.5f);
+    }
+
+    int x0 = std::max((int)std::floor(rectMin.x), 0);
+    int y0 = std::max((int)std::floor(rectMin.y), 0);
+    int x1 = std::min((int)std::floor(rectMax.x), m_width - 1);
+    int y1 = std::min((int)std::floor(rectMax.y), m_height - 1);
+    if (x0 > x1 || y0 > y1) {
+        // Off screen, that is up to the frustum test
+        return false;
+    }
+
+    // The level where the box covers at most about 2x2 texels
+    int span = std::max(x1 - x0, y1 - y0);
+    int level = 0;
+    while (span > 1 && level + 1 < m_levels.size()) {
+        span >>= 1;
+        level++;
+    }
+
+    const std::vector<float>& depth = m_levels[level];
+    int width = m_levelSizes[level].x;
+    for (int y = y0 >> level; y <= (y1 >> level); y++) {
+        for (int x = x0 >> level; x <= (x1 >> level); x++) {
+            if (depth[x + y*width] >= nearest) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
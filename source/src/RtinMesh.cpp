@@ -0,0 +1,106 @@
+#include "RtinMesh.hpp"
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+RtinMesh::RtinMesh(int gridSize){
+    m_gridSize = gridSize;
+    int tileSize = gridSize - 1;
+    m_numTriangles = tileSize * tileSize * 2 - 2;
+    m_numParentTriangles = m_numTriangles - tileSize * tileSize;
+    m_coords.resize(m_numTriangles * 4);
+
+    // Triangles are numbered like a binary heap, the two roots split the
+    // grid along its diagonal and the bits of the id pick the left or
+    // right half at every split below them
+    for (int i = 0; i < m_numTriangles; i++) {
+        int id = i + 2;
+        int ax = 0, ay = 0, bx = 0, by = 0, cx = 0, cy = 0;
+        if (id & 1) {
+            bx = by = cx = tileSize;
+        } else {
+            ax = ay = cy = tileSize;
+        }
+        while ((id >>= 1) > 1) {
+            int mx = (ax + bx) >> 1;
+            int my = (ay + by) >> 1;
+            if (id & 1) {
+                bx = ax; by = ay;
+                ax = cx; ay = cy;
+            } else {
+                ax = bx; ay = by;
+                bx = cx; by = cy;
+            }
+            cx = mx;
+            cy = my;
+        }
+        m_coords[i*4 + 0] = ax;
+        m_coords[i*4 + 1] = ay;
+        m_coords[i*4 + 2] = bx;
+        m_coords[i*4 + 3] = by;
+    }
+}
+
+std::vector<float> RtinMesh::ComputeErrors(const float* heights, int stride) const{
+    int size = m_gridSize;
+    int tileSize = size - 1;
+    std::vector<float> errors(size * size, 0.0f);
+
+    // Border vertices can never be dropped
+    for (int i = 0; i < size; i++) {
+        errors[i] = FLT_MAX;
+        errors[i + tileSize*size] = FLT_MAX;
+        errors[i*size] = FLT_MAX;
+        errors[tileSize + i*size] = FLT_MAX;
+    }
+
+    // Smallest triangles first, so the error of a vertex also covers every
+    // vertex that can only be used once it is
+    for (int i = m_numTriangles - 1; i >= 0; i--) {
+        int ax = m_coords[i*4 + 0];
+        int ay = m_coords[i*4 + 1];
+        int bx = m_coords[i*4 + 2];
+        int by = m_coords[i*4 + 3];
+        int mx = (ax + bx) >> 1;
+        int my = (ay + by) >> 1;
+        int cx = mx + my - ay;
+        int cy = my + ax - mx;
+
+        float interpolated = (heights[(ax + ay*size) * stride] + heights[(bx + by*size) * stride]) * 0.5f;
+        int middle = mx + my*size;
+        float error = std::fabs(interpolated - heights[middle * stride]);
+        errors[middle] = std::max(errors[middle], error);
+
+        if (i < m_numParentTriangles) {
+            int left = ((ax + cx) >> 1) + ((ay + cy) >> 1) * size;
+            int right = ((bx + cx) >> 1) + ((by + cy) >> 1) * size;
+            errors[middle] = std::max(errors[middle], std::max(errors[left], errors[right]));
+        }
+    }
+    return errors;
+}
+
+std::vector<int> RtinMesh::Triangulate(const std::vector<float>& errors, float maxError) const{
+    std::vector<int> indices;
+    int max = m_gridSize - 1;
+    AddTriangle(errors, maxError, indices, 0, 0, max, max, max, 0);
+    AddTriangle(errors, maxError, indices, max, max, 0, 0, 0, max);
+    return indices;
+}
+
+void RtinMesh::AddTriangle(const std::vector<float>& errors, float maxError, std::vector<int>& indices,
+                           int ax, int ay, int bx, int by, int cx, int cy) const{
+    int mx = (ax + bx) >> 1;
+    int my = (ay + by) >> 1;
+    int leg = std::abs(ax - cx) + std::abs(ay - cy);
+
+    if (leg > 1 && (errors[mx + my*m_gridSize] > maxError || leg > MAX_LEG)) {
+        AddTriangle(errors, maxError, indices, cx, cy, ax, ay, mx, my);
+        AddTriangle(errors, maxError, indices, bx, by, cx, cy, mx, my);
+    } else {
+        indices.push_back(ax + ay*m_gridSize);
+        indices.push_back(bx + by*m_gridSize);
+        indices.push_back(cx + cy*m_gridSize);
+    }
+}
@@ -3,6 +3,16 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <vector>
+#include <iterator>
+#include <filesystem>
+
+#include "Fingerprint.hpp"
+
+// Every cached program binary starts with this tag
+static const uint32_t BINARY_MAGIC = 0x42505254; // "TRPB"
+
+std::string Shader::s_binaryCache;
 
 // Constructor
 Shader::Shader(){}
@@ -28,7 +38,9 @@ void Shader::Log(const char* system, const char* message){
     std::cout << "[" << system << "]" << message << "\n";
 }
 
-// Loads a shader and returns a string
+// Loads a shader and returns a string.
+// Lines of the form #include "file" are replaced by that file, which is
+// looked up next to the shader that includes it.
 std::string Shader::LoadShader(const std::string& fname){
 		std::string result;
 		// 1.) Get every line of data
@@ -37,6 +49,13 @@ std::string Shader::LoadShader(const std::string& fname){
 
 		if(myFile.is_open()){
 			while(getline(myFile,line)){
+					if(line.compare(0, 9, "#include ") == 0){
+						size_t first = line.find('"');
+						size_t last = line.rfind('"');
+						std::string directory = fname.substr(0, fname.find_last_of('/') + 1);
+						result += LoadShader(directory + line.substr(first + 1, last - first - 1));
+						continue;
+					}
 					result += line + '\n';
 					// SDL_Log(line); 	// Uncomment this if you want to see
 										// the shader code get printed out.
@@ -52,60 +71,146 @@ std::string Shader::LoadShader(const std::string& fname){
 
 
 void Shader::CreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource){
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-    try {
-        vShaderFile.open(vertexShaderSource);
-        fShaderFile.open(fragmentShaderSource);
-
-        std::stringstream vShaderStream, fShaderStream;
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
+    const std::string files[2] = { vertexShaderSource, fragmentShaderSource };
+    const GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+    CreateProgram(files, types, 2);
+}
 
-        vShaderFile.close();
-        fShaderFile.close();
+void Shader::CreateShader(const std::string& vertexShaderSource, const std::string& tessControlShaderSource,
+                          const std::string& tessEvaluationShaderSource, const std::string& fragmentShaderSource){
+    const std::string files[4] = { vertexShaderSource, tessControlShaderSource, tessEvaluationShaderSource, fragmentShaderSource };
+    const GLenum types[4] = { GL_VERTEX_SHADER, GL_TESS_CONTROL_SHADER, GL_TESS_EVALUATION_SHADER, GL_FRAGMENT_SHADER };
+    CreateProgram(files, types, 4);
+}
 
-        vertexCode   = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+void Shader::CreateProgram(const std::string* files, const GLenum* types, int count){
+    std::vector<std::string> sources(count);
+    for (int i = 0; i < count; i++) {
+        sources[i] = LoadShader(files[i]);
     }
-    catch(std::ifstream::failure e) {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
-    }
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
+    m_shaderID = glCreateProgram();
     
-    unsigned int vertex, fragment;
+    // Drivers without any binary format (or older than 4.1) always compile
+    GLint formats = 0;
+    if (GLAD_GL_VERSION_4_1) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    }
+    std::string binaryPath;
+    if (!s_binaryCache.empty() && formats > 0) {
+        Fingerprint key;
+        key.Add(std::string((const char*)glGetString(GL_VENDOR)));
+        key.Add(std::string((const char*)glGetString(GL_RENDERER)));
+        key.Add(std::string((const char*)glGetString(GL_VERSION)));
+        for (int i = 0; i < count; i++) {
+            key.Add((int)types[i]);
+            key.Add(sources[i]);
+        }
+        binaryPath = s_binaryCache + "/" + key.ToString() + ".bin";
+        if (LoadBinary(binaryPath)) {
+            ReflectUniforms();
+            return;
+        }
+    }
     
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
+    std::vector<unsigned int> stages;
+    for (int i = 0; i < count; i++) {
+        unsigned int stage = CompileShader(types[i], sources[i]);
+        if (stage == 0) {
+            Log("CreateShader ERROR", (files[i] + " failed to compile").c_str());
+            continue;
+        }
+        glAttachShader(m_shaderID, stage);
+        stages.push_back(stage);
+    }
+    if (!binaryPath.empty()) {
+        glProgramParameteri(m_shaderID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(m_shaderID);
+    bool linked = CheckLinkStatus(m_shaderID);
+    if (!linked) {
+        Log("CreateShader ERROR", (files[0] + " program failed to link").c_str());
+    }
+    ReflectUniforms();
     
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
+    for (int i = 0; i < stages.size(); i++) {
+        glDetachShader(m_shaderID, stages[i]);
+        glDeleteShader(stages[i]);
+    }
+    if (linked && stages.size() == count && !binaryPath.empty()) {
+        SaveBinary(binaryPath);
+    }
+}
+
+void Shader::SetBinaryCache(const std::string& directory){
+    s_binaryCache = directory;
+    if (s_binaryCache.empty()) {
+        return;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(s_binaryCache, error);
+    if (error) {
+        std::cout << "[Shader]could not create the program cache directory, programs will be compiled\n";
+        s_binaryCache.clear();
+    }
+}
+
+bool Shader::LoadBinary(const std::string& path){
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    uint32_t magic = 0;
+    GLenum format = 0;
+    file.read((char*)&magic, sizeof(magic));
+    file.read((char*)&format, sizeof(format));
+    std::vector<char> binary;
+    if (file) {
+        binary.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    if (magic != BINARY_MAGIC || binary.empty()) {
+        Log("Shader", ("program cache " + path + " is damaged, compiling instead").c_str());
+        return false;
+    }
     
-    m_shaderID = glCreateProgram();
-    glAttachShader(m_shaderID, vertex);
-    glAttachShader(m_shaderID, fragment);
-    glLinkProgram(m_shaderID);
+    glProgramBinary(m_shaderID, format, binary.data(), binary.size());
+    // A driver update can reject binaries it wrote itself, which is not
+    // an error, the program is just built again
+    GLint result = GL_FALSE;
+    glGetProgramiv(m_shaderID, GL_LINK_STATUS, &result);
+    return result == GL_TRUE;
+}
+
+void Shader::SaveBinary(const std::string& path){
+    GLint length = 0;
+    glGetProgramiv(m_shaderID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(m_shaderID, length, &length, &format, binary.data());
     
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    // Written aside and renamed, so a crash never leaves half a binary
+    std::string temporary = path + ".tmp";
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    file.write((const char*)&BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    file.write((const char*)&format, sizeof(format));
+    file.write(binary.data(), length);
+    file.close();
+    std::error_code error;
+    if (!file) {
+        std::filesystem::remove(temporary, error);
+        Log("Shader", ("could not write the program cache " + path).c_str());
+        return;
+    }
+    std::filesystem::rename(temporary, path, error);
 }
 
 
 unsigned int Shader::CompileShader(unsigned int type, const std::string& source){
   // Compile our shaders
   // id is the type of shader (Vertex, fragment, etc.)
-  unsigned int id;
-
-  if(type == GL_VERTEX_SHADER){
-    id = glCreateShader(GL_VERTEX_SHADER);
-  }else if(type == GL_FRAGMENT_SHADER){
-    id = glCreateShader(GL_FRAGMENT_SHADER);
-  }
+  unsigned int id = glCreateShader(type);
   const char* src = source.c_str();
   // The source of our shader
   glShaderSource(id, 1, &src, nullptr);
@@ -123,11 +228,14 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
       glGetShaderInfoLog(id, length, &length, errorMessages);
       if(type == GL_VERTEX_SHADER){
 		Log("CompileShader ERROR", "GL_VERTEX_SHADER compilation failed!");
-		Log("CompileShader ERROR", (const char*)errorMessages);
+      }else if(type == GL_TESS_CONTROL_SHADER){
+		Log("CompileShader ERROR", "GL_TESS_CONTROL_SHADER compilation failed!");
+      }else if(type == GL_TESS_EVALUATION_SHADER){
+		Log("CompileShader ERROR", "GL_TESS_EVALUATION_SHADER compilation failed!");
       }else if(type == GL_FRAGMENT_SHADER){
         Log("CompileShader ERROR","GL_FRAGMENT_SHADER compilation failed!");
-		Log("CompileShader ERROR",(const char*)errorMessages);
       }
+      Log("CompileShader ERROR",(const char*)errorMessages);
       // Reclaim our memory
       delete[] errorMessages;
       // Delete our broken shader
@@ -164,12 +272,19 @@ GLuint Shader::GetID() const{
     return m_shaderID;
 }
 
+void Shader::BindUniformBlock(const GLchar* name, GLuint binding){
+    GLuint index = glGetUniformBlockIndex(m_shaderID, name);
+    if(index != GL_INVALID_INDEX){
+        glUniformBlockBinding(m_shaderID, index, binding);
+    }
+}
+
 
 // Set our uniforms for our shader.
 void Shader::SetUniformMatrix4fv(const GLchar* name, const GLfloat* value){
     // Note that we are now 'looking' inside the shader for a particular
     // variable. This means the name has to exactly match!
-    GLint location = glGetUniformLocation(m_shaderID,name);
+    GLint location = FindUniform(name);
 
     // Now update this information through our uniforms.
     // glUniformMatrix4v means a 4x4 matrix of floats
@@ -178,18 +293,150 @@ void Shader::SetUniformMatrix4fv(const GLchar* name, const GLfloat* value){
 
 // Set our uniforms for our shader (Useful for a vec3).
 void Shader::SetUniform3f(const GLchar* name, float v0, float v1, float v2){
-    GLint location = glGetUniformLocation(m_shaderID,name);
+    GLint location = FindUniform(name);
     glUniform3f(location, v0, v1, v2);
 }
 
 // Sets 1 int value in our uniform (That is why the suffix is 1i).
 void Shader::SetUniform1i(const GLchar* name, int value){
-    GLint location = glGetUniformLocation(m_shaderID,name);
+    GLint location = FindUniform(name);
     glUniform1i(location, value);
 }
 
 // Sets 1 float value in our uniform (That is why the suffix is 1f).
 void Shader::SetUniform1f(const GLchar* name, float value){
-    GLint location = glGetUniformLocation(m_shaderID,name);
+    GLint location = FindUniform(name);
     glUniform1f(location, value);
 }
+
+// Set our uniforms for our shader (Useful for a vec2).
+void Shader::SetUniform2f(const GLchar* name, float v0, float v1){
+    GLint location = FindUniform(name);
+    glUniform2f(location, v0, v1);
+}
+
+// Set our uniforms for our shader (Useful for a vec4).
+void Shader::SetUniform4f(const GLchar* name, float v0, float v1, float v2, float v3){
+    GLint location = FindUniform(name);
+    glUniform4f(location, v0, v1, v2, v3);
+}
+
+// Sets an array of ints, 'name' is the array (e.g. "u_Array") or its first element.
+void Shader::SetUniform1iv(const GLchar* name, int count, const int* values){
+    GLint location = FindUniform(name);
+    glUniform1iv(location, count, values);
+}
+
+// Sets an array of floats.
+void Shader::SetUniform1fv(const GLchar* name, int count, const float* values){
+    GLint location = FindUniform(name);
+    glUniform1fv(location, count, values);
+}
+
+// Sets an array of vec3s, 'values' holds 3 floats per element.
+void Shader::SetUniform3fv(const GLchar* name, int count, const float* values){
+    GLint location = FindUniform(name);
+    glUniform3fv(location, count, values);
+}
+
+void Shader::ReflectUniforms(){
+    m_uniforms.clear();
+    GLint count = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(m_shaderID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_shaderID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    
+    std::string name(maxLength, '\0');
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_shaderID, i, maxLength, &length, &size, &type, &name[0]);
+        std::string uniformName = name.substr(0, length);
+        UniformInfo info = { glGetUniformLocation(m_shaderID, uniformName.c_str()), type };
+        // Uniforms in blocks have no location
+        if (info.location < 0) {
+            continue;
+        }
+        m_uniforms[uniformName] = info;
+        if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0) {
+            m_uniforms[uniformName.substr(0, uniformName.size() - 3)] = info;
+        }
+    }
+}
+
+GLint Shader::FindUniform(const std::string& name){
+    auto it = m_uniforms.find(name);
+    if (it != m_uniforms.end()) {
+        return it->second.location;
+    }
+    // Remembered as missing, so it is only reported once
+    Log("Shader", ("uniform " + name + " is not used by program " + std::to_string(m_shaderID)).c_str());
+    m_uniforms[name] = UniformInfo{ -1, 0 };
+    return -1;
+}
+
+// Samplers are set like ints
+static bool IsSampler(GLenum type){
+    return type == GL_SAMPLER_1D || type == GL_SAMPLER_2D || type == GL_SAMPLER_3D || type == GL_SAMPLER_CUBE
+        || type == GL_SAMPLER_2D_ARRAY || type == GL_SAMPLER_BUFFER
+        || type == GL_INT_SAMPLER_BUFFER || type == GL_UNSIGNED_INT_SAMPLER_BUFFER;
+}
+
+GLint Shader::FindUniform(const std::string& name, GLenum type){
+    GLint location = FindUniform(name);
+    UniformInfo& info = m_uniforms[name];
+    if (location >= 0 && info.type != type && !(type == GL_INT && IsSampler(info.type))) {
+        Log("Shader", ("uniform " + name + " does not have the type it is set with").c_str());
+        info.type = type;
+    }
+    return location;
+}
+
+template<> void Shader::Uniform<int>::Set(const int& value) const{
+    glUniform1i(m_location, value);
+}
+
+template<> void Shader::Uniform<float>::Set(const float& value) const{
+    glUniform1f(m_location, value);
+}
+
+template<> void Shader::Uniform<glm::vec2>::Set(const glm::vec2& value) const{
+    glUniform2f(m_location, value.x, value.y);
+}
+
+template<> void Shader::Uniform<glm::vec3>::Set(const glm::vec3& value) const{
+    glUniform3f(m_location, value.x, value.y, value.z);
+}
+
+template<> void Shader::Uniform<glm::vec4>::Set(const glm::vec4& value) const{
+    glUniform4f(m_location, value.x, value.y, value.z, value.w);
+}
+
+template<> void Shader::Uniform<glm::mat4>::Set(const glm::mat4& value) const{
+    glUniformMatrix4fv(m_location, 1, GL_FALSE, &value[0][0]);
+}
+
+template<> Shader::Uniform<int> Shader::GetUniform<int>(const GLchar* name){
+    return Uniform<int>(FindUniform(name, GL_INT));
+}
+
+template<> Shader::Uniform<float> Shader::GetUniform<float>(const GLchar* name){
+    return Uniform<float>(FindUniform(name, GL_FLOAT));
+}
+
+template<> Shader::Uniform<glm::vec2> Shader::GetUniform<glm::vec2>(const GLchar* name){
+    return Uniform<glm::vec2>(FindUniform(name, GL_FLOAT_VEC2));
+}
+
+template<> Shader::Uniform<glm::vec3> Shader::GetUniform<glm::vec3>(const GLchar* name){
+    return Uniform<glm::vec3>(FindUniform(name, GL_FLOAT_VEC3));
+}
+
+template<> Shader::Uniform<glm::vec4> Shader::GetUniform<glm::vec4>(const GLchar* name){
+    return Uniform<glm::vec4>(FindUniform(name, GL_FLOAT_VEC4));
+}
+
+template<> Shader::Uniform<glm::mat4> Shader::GetUniform<glm::mat4>(const GLchar* name){
+    return Uniform<glm::mat4>(FindUniform(name, GL_FLOAT_MAT4));
+}
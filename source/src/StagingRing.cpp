@@ -0,0 +1,69 @@
+#include "StagingRing.hpp"
+
+#include <iostream>
+
+StagingRing::StagingRing(GLsizeiptr regionSize, int regions){
+    m_regionSize = regionSize;
+    m_current = 0;
+    m_mappedSize = 0;
+    m_fences.resize(regions > 0 ? regions : 1, 0);
+
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, m_buffer);
+    glBufferData(GL_COPY_READ_BUFFER, m_regionSize * m_fences.size(), nullptr, GL_STREAM_DRAW);
+}
+
+StagingRing::~StagingRing(){
+    for (int i = 0; i < m_fences.size(); i++) {
+        if (m_fences[i]) {
+            glDeleteSync(m_fences[i]);
+        }
+    }
+    glDeleteBuffers(1, &m_buffer);
+}
+
+void* StagingRing::Map(GLsizeiptr size){
+    if (size > m_regionSize) {
+        std::cout << "[StagingRing] " << size << " bytes do not fit in a region of " << m_regionSize << "\n";
+        return nullptr;
+    }
+
+    // The region is reused only once the copy out of it has finished
+    GLsync& fence = m_fences[m_current];
+    if (fence) {
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(fence);
+        fence = 0;
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, m_buffer);
+    void* data = glMapBufferRange(GL_COPY_READ_BUFFER, m_current * m_regionSize, size,
+                                  GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    m_mappedSize = data ? size : 0;
+    return data;
+}
+
+bool StagingRing::Unmap(GLuint buffer, GLintptr offset){
+    if (m_mappedSize == 0) {
+        return false;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, m_buffer);
+    if (glUnmapBuffer(GL_COPY_READ_BUFFER) == GL_FALSE) {
+        // What was written is undefined now, so there is nothing to copy
+        std::cout << "[StagingRing] staging region was lost while mapped\n";
+        m_mappedSize = 0;
+        return false;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, m_current * m_regionSize, offset, m_mappedSize);
+
+    m_fences[m_current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_current = (m_current + 1) % m_fences.size();
+    m_mappedSize = 0;
+    return true;
+}
+
+GLsizeiptr StagingRing::GetRegionSize() const{
+    return m_regionSize;
+}
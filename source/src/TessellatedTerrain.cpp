@@ -0,0 +1,75 @@
+#include "TessellatedTerrain.hpp"
+
+#include <vector>
+
+TessellatedTerrain::TessellatedTerrain(int chunkCells, int patchCells){
+    m_chunkCells = chunkCells;
+    m_patchCells = patchCells;
+
+    // Patch corners, in cells from the chunk's first vertex
+    std::vector<float> vertices;
+    std::vector<GLuint> indices;
+    int patches = chunkCells / patchCells;
+    int width = patches + 1;
+    for (int y = 0; y <= patches; y++) {
+        for (int x = 0; x <= patches; x++) {
+            vertices.push_back(x * patchCells);
+            vertices.push_back(y * patchCells);
+        }
+    }
+    // Corners go (0, 0), (1, 0), (1, 1), (0, 1) in the patch's (u, v)
+    for (int y = 0; y < patches; y++) {
+        for (int x = 0; x < patches; x++) {
+            int pos = x + y*width;
+            indices.push_back(pos);
+            indices.push_back(pos + 1);
+            indices.push_back(pos + 1 + width);
+            indices.push_back(pos + width);
+        }
+    }
+    m_patchVertexCount = width * width;
+    m_indexCount = indices.size();
+
+    glGenVertexArrays(1, &m_VAO);
+    glGenBuffers(1, &m_VBO);
+    glGenBuffers(1, &m_EBO);
+
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+}
+
+TessellatedTerrain::~TessellatedTerrain(){
+    glDeleteVertexArrays(1, &m_VAO);
+    glDeleteBuffers(1, &m_VBO);
+    glDeleteBuffers(1, &m_EBO);
+}
+
+void TessellatedTerrain::Bind(Shader& shader, const HeightTextureArray& heights){
+    heights.Bind(GL_TEXTURE0);
+    shader.SetUniform1i("u_Heights", 0);
+    shader.SetUniform1f("u_HeightMin", heights.GetMinHeight());
+    shader.SetUniform1f("u_HeightRange", heights.GetHeightRange());
+    shader.SetUniform1f("u_ChunkCells", (float)m_chunkCells);
+    shader.SetUniform1f("u_MaxTessLevel", (float)m_patchCells);
+    m_chunkOrigin = shader.GetUniform<glm::vec3>("u_ChunkOrigin");
+    m_layer = shader.GetUniform<float>("u_Layer");
+
+    glBindVertexArray(m_VAO);
+    glPatchParameteri(GL_PATCH_VERTICES, 4);
+}
+
+void TessellatedTerrain::Draw(int layer, const glm::vec3& origin) const{
+    m_chunkOrigin.Set(origin);
+    m_layer.Set((float)layer);
+    glDrawElements(GL_PATCHES, m_indexCount, GL_UNSIGNED_INT, 0);
+}
+
+int TessellatedTerrain::GetPatchVertexCount() const{
+    return m_patchVertexCount;
+}
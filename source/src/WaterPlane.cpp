@@ -0,0 +1,72 @@
+#include "WaterPlane.hpp"
+
+#include <vector>
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+WaterPlane::WaterPlane(int gridSize, float size, glm::vec3 color){
+    m_size = size;
+    m_cellSize = size / gridSize;
+
+    // Position, normal and color of each vertex, matching the chunk arena
+    std::vector<float> vertices;
+    std::vector<GLuint> indices;
+    int width = gridSize + 1;
+    for (int y = 0; y <= gridSize; y++) {
+        for (int x = 0; x <= gridSize; x++) {
+            vertices.push_back(x * m_cellSize);
+            vertices.push_back(0.0f);
+            vertices.push_back(y * m_cellSize);
+            vertices.push_back(0.0f);
+            vertices.push_back(1.0f);
+            vertices.push_back(0.0f);
+            vertices.push_back(color.r);
+            vertices.push_back(color.g);
+            vertices.push_back(color.b);
+        }
+    }
+    for (int y = 0; y < gridSize; y++) {
+        for (int x = 0; x < gridSize; x++) {
+            int pos = x + y*width;
+            indices.push_back(pos + width);
+            indices.push_back(pos);
+            indices.push_back(pos + width + 1);
+            indices.push_back(pos + 1);
+            indices.push_back(pos + 1 + width);
+            indices.push_back(pos);
+        }
+    }
+    m_indexCount = indices.size();
+
+    glGenVertexArrays(1, &m_VAO);
+    glGenBuffers(1, &m_VBO);
+    glGenBuffers(1, &m_EBO);
+
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    for (int i = 0; i < 3; i++) {
+        glVertexAttribPointer(i, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(i * 3 * sizeof(float)));
+        glEnableVertexAttribArray(i);
+    }
+    glBindVertexArray(0);
+}
+
+WaterPlane::~WaterPlane(){
+    glDeleteVertexArrays(1, &m_VAO);
+    glDeleteBuffers(1, &m_VBO);
+    glDeleteBuffers(1, &m_EBO);
+}
+
+void WaterPlane::Render(Shader& shader, const glm::vec3& eye, float height) const{
+    glm::vec3 corner(std::floor(eye.x / m_cellSize) * m_cellSize - m_size * 0.5f, height,
+                     std::floor(eye.z / m_cellSize) * m_cellSize - m_size * 0.5f);
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), corner);
+    shader.SetUniformMatrix4fv("u_ModelMatrix", &model[0][0]);
+
+    glBindVertexArray(m_VAO);
+    glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, (void*)0);
+}
@@ -0,0 +1,113 @@
+#include "WorkerPool.hpp"
+
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+WorkerPool::WorkerPool(int threads){
+    m_pending = 0;
+    m_stop = false;
+    for (int i = 0; i < std::max(threads, 1); i++) {
+        m_workers.push_back(std::thread(&WorkerPool::WorkerLoop, this));
+    }
+}
+
+WorkerPool::~WorkerPool(){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (int i = 0; i < m_workers.size(); i++) {
+        m_workers[i].join();
+    }
+}
+
+void WorkerPool::Submit(std::function<void()> task){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+        m_pending++;
+    }
+    m_wake.notify_one();
+}
+
+void WorkerPool::Wait(){
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_pending == 0; });
+}
+
+int WorkerPool::GetThreads() const{
+    return m_workers.size();
+}
+
+void WorkerPool::WorkerLoop(){
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+            // Queued tasks are still run before stopping
+            if (m_tasks.empty()) {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        task();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_pending == 0) {
+            m_idle.notify_all();
+        }
+    }
+}
+
+void WorkerPool::ParallelFor(int count, int grain, const std::function<void(int, int)>& job){
+    grain = std::max(grain, 1);
+    int ranges = (count + grain - 1) / grain;
+    if (ranges <= 1) {
+        if (count > 0) {
+            job(0, count);
+        }
+        return;
+    }
+
+    // Helpers may only get to run after every range is done, so what
+    // they touch lives as long as the last of them
+    struct Batch{
+        std::function<void(int, int)> job;
+        std::atomic<int> next;
+        int done;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+    batch->job = job;
+    batch->next = 0;
+    batch->done = 0;
+
+    auto run = [batch, count, grain, ranges]() {
+        int ran = 0;
+        for (int range = batch->next++; range < ranges; range = batch->next++) {
+            batch->job(range * grain, std::min(count, (range + 1) * grain));
+            ran++;
+        }
+        if (ran > 0) {
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            batch->done += ran;
+            if (batch->done == ranges) {
+                batch->finished.notify_all();
+            }
+        }
+    };
+    int helpers = std::min(ranges - 1, (int)m_workers.size());
+    for (int i = 0; i < helpers; i++) {
+        Submit(run);
+    }
+    run();
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->finished.wait(lock, [&batch, ranges]() { return batch->done == ranges; });
+}
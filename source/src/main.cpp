@@ -4,6 +4,10 @@
 #include <iostream>
 #include <math.h>
 #include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <memory>
 
 #include <glad/glad.h>
 #include <SDL2/SDL.h>
@@ -14,11 +18,33 @@
 #include "Shader.hpp"
 #include "Camera.hpp"
 #include "PerlinNoise.hpp"
+#include "ChunkArena.hpp"
+#include "ChunkStore.hpp"
+#include "HeightCodec.hpp"
+#include "Fingerprint.hpp"
+#include "ChunkPipeline.hpp"
+#include "ChunkLod.hpp"
+#include "CdlodTerrain.hpp"
+#include "GeometryClipmap.hpp"
+#include "Frustum.hpp"
+#include "HorizonCuller.hpp"
+#include "OcclusionRasterizer.hpp"
+#include "WorkerPool.hpp"
+#include "RtinMesh.hpp"
+#include "WaterPlane.hpp"
+#include "FrameUniforms.hpp"
+#include "FrameClock.hpp"
+#include "FrameCapture.hpp"
+#include "FarFieldRing.hpp"
+#include "TessellatedTerrain.hpp"
+#include "HeightTextureArray.hpp"
+#include "HeightmapTerrain.hpp"
 
 int gScreenWidth = 1920;
 int gScreenHeight = 1080;
 SDL_Window* window 	= nullptr;
 SDL_GLContext glContext;
+std::string windowTitle = "Terrain Generator";
 bool quit = false;
 
 // Map params
@@ -26,14 +52,58 @@ float WATER_HEIGHT = 0.1;
 int chunk_render_distance = 3;
 int xMapChunks = 10;
 int yMapChunks = 10;
-int chunkWidth = 127;
-int chunkHeight = 127;
-int gridPosX = 0;
-int gridPosY = 0;
+// Chunks are 2^n + 1 vertices wide so every LOD stride divides them
+int chunkWidth = 129;
+int chunkHeight = 129;
 float originX = (chunkWidth  * xMapChunks) / 2 - chunkWidth / 2;
 float originY = (chunkHeight * yMapChunks) / 2 - chunkHeight / 2;
 
+// Ways of drawing the terrain
+enum TerrainMode {
+    CHUNK_GRID_MODE,    // Chunks generated on the CPU
+    CDLOD_MODE,         // Quadtree of GPU displaced grids
+    CLIPMAP_MODE,       // Nested grids around the camera
+    TESSELLATION_MODE,  // Chunk patches refined by the GPU
+    HEIGHTMAP_MODE      // One grid displaced by each chunk's heightmap
+};
+TerrainMode terrainMode = CHUNK_GRID_MODE;
+// Mode the chunks were last brought up to date for, each mode only
+// generates and uploads what it draws
+TerrainMode mapMode = CHUNK_GRID_MODE;
+
+// Skip chunks hidden behind ridges
+bool horizonCulling = true;
+// Skip chunks hidden behind the software rasterized occluders
+bool occlusionCulling = true;
+// Blocks per chunk side used as occluders by the horizon and occlusion culling
+int occluderBlocks = 8;
+
+// Draw coarse terrain out to the horizon behind the chunks
+bool farFieldEnabled = true;
+// Far field tiles generated per frame at most
+int farFieldBudget = 8;
+
+// Tessellation params, patches are split into segments of about this many pixels
+float tessPixelsPerSegment = 8.0f;
+
+// Lay down the depth of the visible chunks first, so the lit pass only
+// shades the nearest surface of every pixel
+bool depthPrepass = false;
+
+// Level of detail params
+bool lodEnabled = true;
+float lodPixelError = 2.0f;
+
+// Adaptive triangulation params, drawn instead of the level of detail
+// when enabled
+bool rtinEnabled = false;
+float rtinMaxError = 0.5f;
+
 // Noise params
+unsigned int seed = 0;
+// Only a seed given on the command line is likely to come back, so only
+// then are generated chunks stored
+bool seedGiven = false;
 int octaves = 6;
 float meshHeight = 32;
 float noiseScale = 64;
@@ -43,6 +113,23 @@ float lacunarity = 2;
 // Camera
 Camera camera(glm::vec3(originX, 20.0f, originY));
 
+// Camera speed in units per second
+float cameraSpeed = 30.0f;
+
+// Keyboard as it was at the previous simulation step
+Uint8 previousKeys[SDL_NUM_SCANCODES] = {0};
+
+// Frame pacing, the simulation runs at a fixed rate whatever these are
+bool vsyncEnabled = true;
+// Frames per second at most, 0 for no limit
+float fpsCap = 0.0f;
+// Seconds between frame time reports
+float statsInterval = 10.0f;
+
+// Where rendered frames are captured to, nothing is captured when empty
+std::string capturePath;
+FrameCapture::Format captureFormat = FrameCapture::PPM_FRAMES;
+
 // Mouse
 int mouseX = gScreenWidth / 2;
 int mouseY = gScreenHeight / 2;
@@ -57,8 +144,40 @@ glm::vec3 mountain1 = glm::vec3(0.35, 0.25, 0.25);
 glm::vec3 mountain2 = glm::vec3(0.3, 0.25, 0.2);
 glm::vec3 snow = glm::vec3(1, 1, 1);
 
-// Generate random permutation vector
-std::vector<int> p = getPermutationVector();
+// Permutation vector, built from the seed once it is known
+std::vector<int> p;
+
+// Chunk indices sorted from the nearest to the farthest, kept between
+// frames so each sort starts out almost done
+std::vector<int> drawOrder;
+
+// Draws of the visible chunks, built by the workers and replayed on the
+// GL thread
+struct DrawList {
+    std::vector<int> slots;
+    std::vector<GLsizei> counts;
+    std::vector<GLsizei> firstIndices;
+    // Chunks culled by each test, for the window title
+    int inFrustum = 0;
+    int submerged = 0;
+    int behindHorizon = 0;
+    int occluded = 0;
+};
+// Kept between frames so its storage is reused
+DrawList drawList;
+
+// Bounds of every chunk, they only change when the map is regenerated
+BoxList chunkBoxes;
+
+// Chunk generation stages
+int noiseStage;
+int meshStage;
+int normalsStage;
+int colorsStage;
+int lodStage;
+int boundsStage;
+int rtinStage;
+int heightsStage;
 
 struct terrainColor {
     terrainColor(float _height, glm::vec3 _color) {
@@ -69,28 +188,442 @@ struct terrainColor {
     glm::vec3 color;
 };
 
-void render(std::vector<GLuint> &map_chunks, Shader &shader, glm::mat4 &view, glm::mat4 &model, glm::mat4 &projection, int &nIndices) {
+struct mapChunk {
+    // Where the chunk's vertices live inside the arena
+    int slot = -1;
+    // Cache keys of the artifacts currently uploaded for this chunk
+    uint64_t meshKey = 0;
+    uint64_t normalsKey = 0;
+    uint64_t colorsKey = 0;
+    uint64_t rtinKey = 0;
+    uint64_t heightsKey = 0;
+    // Adaptive triangulation inside the arena's index buffer
+    GLsizei rtinFirst = 0;
+    GLsizei rtinCount = 0;
+    // Height error of each level of detail
+    std::vector<float> lodErrors;
+    // Lowest and highest vertex, for culling
+    float minHeight = 0;
+    float maxHeight = 0;
+    // Lowest and highest vertex of each occluder block, row by row
+    std::vector<float> occluderHeights;
+    std::vector<float> blockMaxHeights;
+    // Lowest and highest sample of the height map, for culling the modes
+    // that build their vertices on the GPU
+    float heightsMin = 0;
+    float heightsMax = 0;
+    // Level of detail picked for the current frame
+    int lod = 0;
+    // Distance from the camera to the chunk's bounds this frame
+    float distance = 0;
+    bool visible = false;
+};
 
-    glClearColor(0.53, 0.8, 0.92, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+// Height of the water surface, the terrain below it is covered by the water plane
+float waterLevel() {
+    return WATER_HEIGHT * 0.5 * meshHeight;
+}
+
+// Distance up to which chunks are drawn, the far plane of the chunk grid
+float chunkViewDistance() {
+    return (float)chunkWidth * (chunk_render_distance - 1.2f);
+}
+
+// World position of the first vertex of a chunk
+glm::vec3 chunkOrigin(int x, int y) {
+    return glm::vec3(-chunkWidth / 2.0 + (chunkWidth - 1) * x, 0.0, -chunkHeight / 2.0 + (chunkHeight - 1) * y);
+}
+
+// Level a neighbouring chunk is drawn at, or 'fallback' if it is not drawn
+int neighborLod(std::vector<mapChunk> &map_chunks, int x, int y, int fallback) {
+    if (x < 0 || y < 0 || x >= xMapChunks || y >= yMapChunks || !map_chunks[x + y*xMapChunks].visible) {
+        return fallback;
+    }
+    return map_chunks[x + y*xMapChunks].lod;
+}
+
+// How far the drawn surface of a chunk can dip below its vertices, with
+// the coarsest level of detail or the triangulation it may be drawn with
+float surfaceDrop(const mapChunk &chunk) {
+    if (rtinEnabled) {
+        return rtinMaxError;
+    }
+    if (!lodEnabled || chunk.lodErrors.empty()) {
+        return 0.0f;
+    }
+    return *std::max_element(chunk.lodErrors.begin(), chunk.lodErrors.end());
+}
+
+// World space bounding box of a chunk
+void chunkBounds(const mapChunk &chunk, int x, int y, glm::vec3 &min, glm::vec3 &max) {
+    min = chunkOrigin(x, y) + glm::vec3(0.0f, chunk.minHeight, 0.0f);
+    max = chunkOrigin(x, y) + glm::vec3(chunkWidth - 1, chunk.maxHeight, chunkHeight - 1);
+}
+
+// Bounding box of a chunk as drawn from its height map
+void heightMapBounds(const mapChunk &chunk, int x, int y, glm::vec3 &min, glm::vec3 &max) {
+    min = chunkOrigin(x, y) + glm::vec3(0.0f, chunk.heightsMin, 0.0f);
+    max = chunkOrigin(x, y) + glm::vec3(chunkWidth - 1, chunk.heightsMax, chunkHeight - 1);
+}
+
+// Bring drawOrder up to date with the chunk distances. The camera moves
+// little between frames, so an insertion sort only has a few chunks to
+// shift and runs in close to linear time.
+void sortFrontToBack(std::vector<mapChunk> &map_chunks) {
+    if (drawOrder.size() != map_chunks.size()) {
+        drawOrder.resize(map_chunks.size());
+        for (int i = 0; i < drawOrder.size(); i++) {
+            drawOrder[i] = i;
+        }
+    }
+    for (int i = 1; i < drawOrder.size(); i++) {
+        int index = drawOrder[i];
+        int j = i;
+        while (j > 0 && map_chunks[drawOrder[j - 1]].distance > map_chunks[index].distance) {
+            drawOrder[j] = drawOrder[j - 1];
+            j--;
+        }
+        drawOrder[j] = index;
+    }
+}
+
+// Hide the visible chunks that lie behind ridges seen from 'eye', returns
+// how many. Chunks are visited in rings of growing grid distance from the
+// eye's chunk, so along any line of sight nearer chunks are always seen
+// first.
+int cullBehindHorizon(std::vector<mapChunk> &map_chunks, HorizonCuller &horizon, glm::vec3 eye) {
+    glm::vec3 eyeOffset = eye - chunkOrigin(0, 0);
+    int eyeX = (int)std::floor(eyeOffset.x / (chunkWidth - 1));
+    int eyeY = (int)std::floor(eyeOffset.z / (chunkHeight - 1));
     
-    // Compute chunk distance from origin
-    gridPosX = (int)(camera.GetEyeXPosition() - originX) / chunkWidth + xMapChunks / 2;
-    gridPosY = (int)(camera.GetEyeYPosition() - originY) / chunkHeight + yMapChunks / 2;
+    std::vector<std::pair<int, int>> order;
+    for (int y = 0; y < yMapChunks; y++) {
+        for (int x = 0; x < xMapChunks; x++) {
+            if (map_chunks[x + y*xMapChunks].visible) {
+                order.push_back(std::pair<int, int>(std::abs(x - eyeX) + std::abs(y - eyeY), x + y*xMapChunks));
+            }
+        }
+    }
+    std::sort(order.begin(), order.end());
     
-    // Render map chunks that are within render distance
+    int hidden = 0;
+    horizon.Begin(eye);
+    for (int i = 0; i < order.size(); i++) {
+        int x = order[i].second % xMapChunks;
+        int y = order[i].second / xMapChunks;
+        mapChunk &chunk = map_chunks[order[i].second];
+        
+        glm::vec3 min, max;
+        chunkBounds(chunk, x, y, min, max);
+        if (horizon.IsOccluded(min, max)) {
+            chunk.visible = false;
+            hidden++;
+            continue;
+        }
+        
+        // The drawn terrain is solid at least up to the lowest vertex of
+        // each block, less what its level of detail can take off
+        glm::vec3 blockSize = glm::vec3(chunkWidth - 1, 0.0f, chunkHeight - 1) / (float)occluderBlocks;
+        float drop = surfaceDrop(chunk);
+        for (int by = 0; by < occluderBlocks; by++) {
+            for (int bx = 0; bx < occluderBlocks; bx++) {
+                glm::vec3 blockMin = chunkOrigin(x, y) + glm::vec3(bx, 0.0f, by) * blockSize;
+                glm::vec3 blockMax = blockMin + blockSize;
+                blockMax.y = chunk.occluderHeights[bx + by*occluderBlocks] - drop;
+                horizon.AddOccluder(blockMin, blockMax);
+            }
+        }
+    }
+    return hidden;
+}
+
+// Is every block of a chunk hidden in the occlusion buffer. A whole chunk's
+// box nearly always pokes out above the ridge in front of it somewhere,
+// the boxes of its blocks follow the terrain much more closely.
+bool chunkOccluded(const mapChunk &chunk, int x, int y, const OcclusionRasterizer &occlusion) {
+    glm::vec3 min, max;
+    chunkBounds(chunk, x, y, min, max);
+    if (occlusion.IsOccluded(min, max)) {
+        return true;
+    }
+    
+    // A coarse level's triangles reach past the block, so the drawn
+    // surface can leave the block's range by that level's error
+    glm::vec3 blockSize = glm::vec3(chunkWidth - 1, 0.0f, chunkHeight - 1) / (float)occluderBlocks;
+    float drop = surfaceDrop(chunk);
+    for (int by = 0; by < occluderBlocks; by++) {
+        for (int bx = 0; bx < occluderBlocks; bx++) {
+            glm::vec3 blockMin = chunkOrigin(x, y) + glm::vec3(bx, 0.0f, by) * blockSize;
+            glm::vec3 blockMax = blockMin + blockSize;
+            blockMin.y = chunk.occluderHeights[bx + by*occluderBlocks] - drop;
+            blockMax.y = chunk.blockMaxHeights[bx + by*occluderBlocks] + drop;
+            if (!occlusion.IsOccluded(blockMin, blockMax)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Hide the visible chunks that are behind the terrain in front of them,
+// returns how many. Every chunk is drawn into the occlusion buffer as a
+// coarse grid that stays below its terrain, then every chunk is tested.
+int cullOccluded(std::vector<mapChunk> &map_chunks, OcclusionRasterizer &occlusion, const glm::mat4 &viewProjection) {
+    // Every block is solid up to its lowest vertex, less what the level
+    // of detail can take off. Its top and sides make up the proxy, 8
+    // corners and 10 triangles per block.
+    const int boxIndices[30] = { 4, 5, 6, 4, 6, 7,      // Top
+                                 0, 1, 5, 0, 5, 4,      // Sides
+                                 1, 2, 6, 1, 6, 5,
+                                 2, 3, 7, 2, 7, 6,
+                                 3, 0, 4, 3, 4, 7 };
+    int blocks = occluderBlocks * occluderBlocks;
+    std::vector<glm::vec3> vertices(blocks * 8);
+    std::vector<int> indices;
+    for (int i = 0; i < blocks; i++) {
+        for (int j = 0; j < 30; j++) {
+            indices.push_back(i * 8 + boxIndices[j]);
+        }
+    }
+    glm::vec3 blockSize = glm::vec3(chunkWidth - 1, 0.0f, chunkHeight - 1) / (float)occluderBlocks;
+    
+    occlusion.Begin(viewProjection);
+    for (int cy = 0; cy < yMapChunks; cy++) {
+        for (int cx = 0; cx < xMapChunks; cx++) {
+            mapChunk &chunk = map_chunks[cx + cy*xMapChunks];
+            if (!chunk.visible) {
+                continue;
+            }
+            float drop = surfaceDrop(chunk);
+            for (int by = 0; by < occluderBlocks; by++) {
+                for (int bx = 0; bx < occluderBlocks; bx++) {
+                    glm::vec3 corner = chunkOrigin(cx, cy) + glm::vec3(bx, 0.0f, by) * blockSize;
+                    float top = chunk.occluderHeights[bx + by*occluderBlocks] - drop;
+                    glm::vec3* box = &vertices[(bx + by*occluderBlocks) * 8];
+                    for (int k = 0; k < 8; k++) {
+                        glm::vec3 offset = glm::vec3(k == 1 || k == 2 || k == 5 || k == 6, 0.0f, (k & 3) >= 2) * blockSize;
+                        box[k] = corner + offset + glm::vec3(0.0f, k < 4 ? chunk.minHeight - drop : top, 0.0f);
+                    }
+                }
+            }
+            occlusion.AddOccluder(vertices, indices);
+        }
+    }
+    occlusion.Rasterize();
+    
+    int hidden = 0;
     for (int y = 0; y < yMapChunks; y++) {
         for (int x = 0; x < xMapChunks; x++) {
-            if (std::abs(gridPosX - x) <= chunk_render_distance && (y - gridPosY) <= chunk_render_distance) {
-                model = glm::mat4(1.0f);
-                model = glm::translate(model, glm::vec3(-chunkWidth / 2.0 + (chunkWidth - 1) * x, 0.0, -chunkHeight / 2.0 + (chunkHeight - 1) * y));
-                shader.SetUniformMatrix4fv("u_ModelMatrix", &model[0][0]);
-                
-                glBindVertexArray(map_chunks[x + y*xMapChunks]);
-                glDrawElements(GL_TRIANGLES, nIndices, GL_UNSIGNED_INT, 0);
+            mapChunk &chunk = map_chunks[x + y*xMapChunks];
+            if (chunk.visible && chunkOccluded(chunk, x, y, occlusion)) {
+                chunk.visible = false;
+                hidden++;
             }
         }
     }
+    return hidden;
+}
+
+// Draw the far field behind everything else. It has its own depth range
+// starting a little before the chunks end, and the depth buffer is
+// cleared afterwards so the chunks always cover it.
+void renderFarField(FarFieldRing &farField, FrameUniforms &frame, Shader &shader, glm::mat4 &projection) {
+    float nearDistance = 0.9f * chunkViewDistance();
+    farField.Update(camera.m_eyePosition, nearDistance, farFieldBudget);
+    
+    glm::mat4 farProjection = glm::perspective(glm::radians(45.0f), (float)gScreenWidth / (float)gScreenHeight, nearDistance, farField.GetViewDistance());
+    glm::mat4 model = glm::mat4(1.0f);
+    frame.SetProjection(farProjection);
+    frame.Upload();
+    shader.SetUniformMatrix4fv("u_ModelMatrix", &model[0][0]);
+    farField.Render();
+    
+    frame.SetProjection(projection);
+    frame.Upload();
+    glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+// Add the body of a chunk at its level of detail, leaving out the blocks
+// that lie entirely under the water plane like the triangulated chunks
+// do. The blocks that are kept and follow each other in the index
+// buffer are merged into one draw.
+void addBody(const mapChunk &chunk, const ChunkLod &lod, DrawList &drawList) {
+    if (chunk.minHeight >= waterLevel()) {
+        ChunkLod::Range range = lod.GetBody(chunk.lod);
+        drawList.slots.push_back(chunk.slot);
+        drawList.counts.push_back(range.count);
+        drawList.firstIndices.push_back(range.first);
+        return;
+    }
+    
+    int blocks = lod.GetBodyBlocks(chunk.lod);
+    // Occluder blocks per side of a body block
+    int span = occluderBlocks / blocks;
+    int merging = -1;
+    for (int by = 0; by < blocks; by++) {
+        for (int bx = 0; bx < blocks; bx++) {
+            float blockMax = chunk.minHeight;
+            for (int y = by * span; y < (by + 1) * span; y++) {
+                for (int x = bx * span; x < (bx + 1) * span; x++) {
+                    blockMax = std::fmax(blockMax, chunk.blockMaxHeights[x + y*occluderBlocks]);
+                }
+            }
+            ChunkLod::Range range = lod.GetBodyBlock(chunk.lod, bx, by);
+            if (blockMax < waterLevel() || range.count == 0) {
+                continue;
+            }
+            if (merging >= 0 && drawList.firstIndices[merging] + drawList.counts[merging] == range.first) {
+                drawList.counts[merging] += range.count;
+                continue;
+            }
+            merging = drawList.counts.size();
+            drawList.slots.push_back(chunk.slot);
+            drawList.counts.push_back(range.count);
+            drawList.firstIndices.push_back(range.first);
+        }
+    }
+}
+
+// Work out which chunks are drawn at which level of detail, and fill
+// 'drawList' with their draws sorted front to back. Runs on a worker,
+// the per chunk passes are split further over the other workers.
+void prepareChunks(std::vector<mapChunk> &map_chunks, ChunkLod &lod, HorizonCuller &horizon, OcclusionRasterizer &occlusion, WorkerPool &workers, const glm::mat4 &viewProjection, glm::vec3 eye, DrawList &drawList) {
+    const int grain = 16;
+    
+    // Only chunks whose bounds reach into the view frustum are drawn,
+    // the far plane takes care of the render distance
+    std::vector<char> visible;
+    workers.ParallelFor(map_chunks.size(), grain, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            glm::vec3 min, max;
+            chunkBounds(map_chunks[i], i % xMapChunks, i / xMapChunks, min, max);
+            glm::vec3 closest = glm::clamp(eye, min, max);
+            map_chunks[i].distance = glm::distance(eye, closest);
+        }
+    });
+    Frustum frustum(viewProjection);
+    drawList.inFrustum = frustum.Cull(chunkBoxes, visible);
+    // Chunks entirely under water are left to the water plane
+    drawList.submerged = 0;
+    for (int i = 0; i < map_chunks.size(); i++) {
+        map_chunks[i].visible = visible[i] && map_chunks[i].maxHeight >= waterLevel();
+        drawList.submerged += visible[i] && !map_chunks[i].visible;
+    }
+    
+    drawList.behindHorizon = horizonCulling ? cullBehindHorizon(map_chunks, horizon, eye) : 0;
+    drawList.occluded = occlusionCulling ? cullOccluded(map_chunks, occlusion, viewProjection) : 0;
+    
+    // Pick a level of detail for the visible chunks, from how many pixels
+    // its height error would cover
+    float projectionScale = gScreenHeight / (2.0f * std::tan(glm::radians(45.0f) / 2.0f));
+    workers.ParallelFor(map_chunks.size(), grain, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            mapChunk &chunk = map_chunks[i];
+            chunk.lod = 0;
+            if (chunk.visible && lodEnabled) {
+                chunk.lod = ChunkLod::SelectLevel(chunk.lodErrors, chunk.distance, projectionScale, lodPixelError);
+            }
+        }
+    });
+    
+    // Render each chunk as its body plus four edges stitched to its
+    // neighbours, or as its own triangulation that keeps every border
+    // vertex. Every visible chunk goes into a single multi-draw, the
+    // vertices find their chunk's origin from their arena slot. The
+    // chunks go in front to back, so the hills in front fill the depth
+    // buffer before what they hide gets shaded.
+    sortFrontToBack(map_chunks);
+    drawList.slots.clear();
+    drawList.counts.clear();
+    drawList.firstIndices.clear();
+    for (int i = 0; i < drawOrder.size(); i++) {
+        int x = drawOrder[i] % xMapChunks;
+        int y = drawOrder[i] / xMapChunks;
+        mapChunk &chunk = map_chunks[drawOrder[i]];
+        if (!chunk.visible) {
+            continue;
+        }
+        
+        if (rtinEnabled) {
+            drawList.slots.push_back(chunk.slot);
+            drawList.counts.push_back(chunk.rtinCount);
+            drawList.firstIndices.push_back(chunk.rtinFirst);
+            continue;
+        }
+        
+        int neighbors[4];
+        neighbors[ChunkLod::SOUTH] = neighborLod(map_chunks, x, y - 1, chunk.lod);
+        neighbors[ChunkLod::EAST] = neighborLod(map_chunks, x + 1, y, chunk.lod);
+        neighbors[ChunkLod::NORTH] = neighborLod(map_chunks, x, y + 1, chunk.lod);
+        neighbors[ChunkLod::WEST] = neighborLod(map_chunks, x - 1, y, chunk.lod);
+        
+        for (int j = 0; j < 4; j++) {
+            ChunkLod::Range range = lod.GetEdge(chunk.lod, j, neighbors[j]);
+            drawList.slots.push_back(chunk.slot);
+            drawList.counts.push_back(range.count);
+            drawList.firstIndices.push_back(range.first);
+        }
+        addBody(chunk, lod, drawList);
+    }
+}
+
+void render(std::vector<mapChunk> &map_chunks, ChunkArena &arena, ChunkLod &lod, HorizonCuller &horizon, OcclusionRasterizer &occlusion, WaterPlane &water, FarFieldRing &farField, WorkerPool &workers, FrameUniforms &frame, Shader &shader, Shader &depthShader, glm::mat4 &view, glm::mat4 &projection) {
+    
+    // The chunks are prepared on the workers from this frame's camera
+    // while this thread clears and draws the far field, then it only
+    // replays the draw list
+    glm::mat4 viewProjection = projection * view;
+    glm::vec3 eye = camera.m_eyePosition;
+    workers.Submit([&]() {
+        prepareChunks(map_chunks, lod, horizon, occlusion, workers, viewProjection, eye, drawList);
+    });
+
+    glClearColor(0.53, 0.8, 0.92, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    
+    if (farFieldEnabled) {
+        renderFarField(farField, frame, shader, projection);
+    }
+    workers.Wait();
+    
+    int percent = std::max(drawList.inFrustum, 1);
+    std::string title = "Terrain Generator - " + std::to_string(drawList.inFrustum - drawList.submerged - drawList.behindHorizon - drawList.occluded) + " chunks drawn, "
+                      + std::to_string(100 * drawList.behindHorizon / percent) + "% hidden by the horizon, "
+                      + std::to_string(100 * drawList.occluded / percent) + "% by occluders";
+    if (title != windowTitle) {
+        windowTitle = title;
+        SDL_SetWindowTitle(window, windowTitle.c_str());
+    }
+    
+    std::vector<int> &slots = drawList.slots;
+    std::vector<GLsizei> &counts = drawList.counts;
+    std::vector<GLsizei> &firstIndices = drawList.firstIndices;
+    glm::mat4 model = glm::mat4(1.0f);
+    arena.Bind();
+    arena.BindOrigins(GL_TEXTURE0);
+    if (depthPrepass && !slots.empty()) {
+        // Depth only, then the lit pass shades just the fragments that
+        // match it and leaves the depth buffer alone
+        depthShader.Bind();
+        depthShader.SetUniformMatrix4fv("u_ModelMatrix", &model[0][0]);
+        depthShader.SetUniform1i("u_SlotVertices", arena.GetSlotVertices());
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        arena.MultiDraw(&slots[0], &counts[0], &firstIndices[0], slots.size());
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
+        shader.Bind();
+    }
+    shader.SetUniformMatrix4fv("u_ModelMatrix", &model[0][0]);
+    shader.SetUniform1i("u_SlotVertices", arena.GetSlotVertices());
+    if (!slots.empty()) {
+        arena.MultiDraw(&slots[0], &counts[0], &firstIndices[0], slots.size());
+    }
+    shader.SetUniform1i("u_SlotVertices", 0);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+    
+    water.Render(shader, camera.m_eyePosition, waterLevel());
 }
 
 std::vector<int> generateIndices() {
@@ -115,93 +648,194 @@ std::vector<int> generateIndices() {
     return indices;
 }
 
-std::vector<float> generateNoiseMap(int offsetX, int offsetY) {
-    std::vector<float> noiseValues;
-    std::vector<float> normalizedNoiseValues;
+// Triangles of a chunk that stay within rtinMaxError of its full mesh.
+// Triangles entirely under water are dropped, those crossing the
+// waterline are kept as a skirt below it.
+// Stage outputs are floats, so each one holds the bits of an int index
+// rather than its value. They are only copied bytewise, never read as
+// floats, and go to the index buffer as they are (see ChunkArena).
+std::vector<float> generateRtin(const RtinMesh &rtin, const std::vector<float> &vertices) {
+    static_assert(sizeof(float) == sizeof(int), "indices are stored in floats");
+    std::vector<float> errors = rtin.ComputeErrors(&vertices[1], 3);
+    std::vector<int> indices = rtin.Triangulate(errors, rtinMaxError);
     
+    std::vector<float> triangles(indices.size());
+    int count = 0;
+    float level = waterLevel();
+    for (int i = 0; i < indices.size(); i += 3) {
+        if (vertices[indices[i]*3 + 1] < level && vertices[indices[i + 1]*3 + 1] < level && vertices[indices[i + 2]*3 + 1] < level) {
+            continue;
+        }
+        std::memcpy(&triangles[count], &indices[i], 3 * sizeof(int));
+        count += 3;
+    }
+    triangles.resize(count);
+    return triangles;
+}
+
+// Sum of every octave at a point in noise space, not yet normalized
+float fractalNoise(float x, float y) {
     float amp  = 1;
     float freq = 1;
+    float noiseHeight = 0;
+    for (int i = 0; i < octaves; i++) {
+        float xSample = x / noiseScale * freq;
+        float ySample = y / noiseScale * freq;
+        
+        float perlinValue = perlinNoise(xSample, ySample, p);
+        noiseHeight += perlinValue * amp;
+        
+        amp  *= persistence;
+        freq *= lacunarity;
+    }
+    return noiseHeight;
+}
+
+float maxNoiseHeight() {
+    float amp = 1;
     float maxPossibleHeight = 0;
-    
     for (int i = 0; i < octaves; i++) {
         maxPossibleHeight += amp;
         amp *= persistence;
     }
+    return maxPossibleHeight;
+}
+
+// Terrain height of a normalized noise value
+float noiseToHeight(float noise) {
+    float easedNoise = std::pow(noise * 1.1, 3);
+    return easedNoise * meshHeight;
+}
+
+// Highest terrain height the noise can reach, every octave at its peak
+float maxTerrainHeight() {
+    float maxPossibleHeight = maxNoiseHeight();
+    return noiseToHeight((maxPossibleHeight + 1) / maxPossibleHeight);
+}
+
+std::vector<float> generateNoiseMap(int offsetX, int offsetY) {
+    std::vector<float> normalizedNoiseValues;
+    float maxPossibleHeight = maxNoiseHeight();
     
     for (int y = 0; y < chunkHeight; y++) {
         for (int x = 0; x < chunkWidth; x++) {
-            amp  = 1;
-            freq = 1;
-            float noiseHeight = 0;
-            for (int i = 0; i < octaves; i++) {
-                float xSample = (x + offsetX * (chunkWidth-1))  / noiseScale * freq;
-                float ySample = (y + offsetY * (chunkHeight-1)) / noiseScale * freq;
-                
-                float perlinValue = perlinNoise(xSample, ySample, p);
-                noiseHeight += perlinValue * amp;
-                
-                amp  *= persistence;
-                freq *= lacunarity;
-            }
-            
-            noiseValues.push_back(noiseHeight);
+            float noiseHeight = fractalNoise(x + offsetX * (chunkWidth-1), y + offsetY * (chunkHeight-1));
+            normalizedNoiseValues.push_back((noiseHeight + 1) / maxPossibleHeight);
         }
     }
-    
-    for (int y = 0; y < chunkHeight; y++) {
+
+    return normalizedNoiseValues;
+}
+
+// Floats in each per-vertex attribute of a chunk
+size_t chunkAttributeSize() {
+    return chunkWidth * chunkHeight * 3;
+}
+
+// The generation kernels below write into 'out', which may be mapped GPU
+// memory, so they never read back what they wrote
+void generateVertices(const std::vector<float> &noise_map, FloatSpan out) {
+    for (int y = 0; y < chunkHeight; y++)
         for (int x = 0; x < chunkWidth; x++) {
-            normalizedNoiseValues.push_back((noiseValues[x + y*chunkWidth] + 1) / maxPossibleHeight);
+            int pos = (x + y*chunkWidth) * 3;
+            out[pos] = x;
+            out[pos + 1] = noiseToHeight(noise_map[x + y*chunkWidth]);
+            out[pos + 2] = y;
+        }
+}
+
+// Terrain heights for a block of world positions, used by the clipmap
+// and the far field. Noise space is offset from the world by half a
+// chunk. Neither has a water plane, so like the shaders they still clamp
+// to the water level.
+void generateHeights(float x, float z, float spacing, int width, int height, float* out) {
+    float maxPossibleHeight = maxNoiseHeight();
+    
+    for (int j = 0; j < height; j++) {
+        for (int i = 0; i < width; i++) {
+            float noiseHeight = fractalNoise(x + i * spacing + chunkWidth / 2.0f, z + j * spacing + chunkHeight / 2.0f);
+            out[i + j*width] = std::fmax(noiseToHeight((noiseHeight + 1) / maxPossibleHeight), waterLevel());
         }
     }
+}
 
-    return normalizedNoiseValues;
+// Heights of a chunk for the tessellation and heightmap modes, which
+// have no water plane either
+std::vector<float> generateHeightMap(const std::vector<float> &noise_map) {
+    std::vector<float> heights(noise_map.size());
+    for (int i = 0; i < noise_map.size(); i++) {
+        heights[i] = std::fmax(noiseToHeight(noise_map[i]), waterLevel());
+    }
+    return heights;
 }
 
-std::vector<float> generateVertices(const std::vector<float> &noise_map) {
-    std::vector<float> v;
+// Lowest and highest vertex of a chunk, then the lowest and the highest
+// vertex of each occluder block
+std::vector<float> generateBounds(const std::vector<float> &vertices) {
+    float minHeight = vertices[1];
+    float maxHeight = vertices[1];
+    for (int i = 4; i < vertices.size(); i += 3) {
+        minHeight = std::fmin(minHeight, vertices[i]);
+        maxHeight = std::fmax(maxHeight, vertices[i]);
+    }
+    int blocks = occluderBlocks * occluderBlocks;
+    std::vector<float> bounds(2 + 2 * blocks);
+    bounds[0] = minHeight;
+    bounds[1] = maxHeight;
     
-    for (int y = 0; y < chunkHeight + 1; y++)
-        for (int x = 0; x < chunkWidth; x++) {
-            v.push_back(x);
-            float easedNoise = std::pow(noise_map[x + y*chunkWidth] * 1.1, 3);
-            v.push_back(std::fmax(easedNoise * meshHeight, WATER_HEIGHT * 0.5 * meshHeight));
-            v.push_back(y);
+    int blockWidth = (chunkWidth - 1) / occluderBlocks;
+    int blockHeight = (chunkHeight - 1) / occluderBlocks;
+    for (int by = 0; by < occluderBlocks; by++) {
+        for (int bx = 0; bx < occluderBlocks; bx++) {
+            float blockMin = maxHeight;
+            float blockMax = minHeight;
+            for (int y = by * blockHeight; y <= (by + 1) * blockHeight; y++) {
+                for (int x = bx * blockWidth; x <= (bx + 1) * blockWidth; x++) {
+                    blockMin = std::fmin(blockMin, vertices[(x + y*chunkWidth)*3 + 1]);
+                    blockMax = std::fmax(blockMax, vertices[(x + y*chunkWidth)*3 + 1]);
+                }
+            }
+            bounds[2 + bx + by*occluderBlocks] = blockMin;
+            bounds[2 + blocks + bx + by*occluderBlocks] = blockMax;
         }
-    
-    return v;
+    }
+    return bounds;
 }
 
-std::vector<float> generateNormals(const std::vector<int> &indices, const std::vector<float> &vertices) {
+void generateNormals(const std::vector<int> &indices, const std::vector<float> &vertices, FloatSpan out) {
     int pos;
     glm::vec3 normal;
-    std::vector<float> normals;
-    std::vector<glm::vec3> verts;
+    std::vector<glm::vec3> vertexNormals(vertices.size() / 3, glm::vec3(0.0f));
     
+    // Every face adds its normal to the vertices it touches
     for (int i = 0; i < indices.size(); i += 3) {
-        
+        glm::vec3 verts[3];
         for (int j = 0; j < 3; j++) {
             pos = indices[i+j]*3;
-            verts.push_back(glm::vec3(vertices[pos], vertices[pos+1], vertices[pos+2]));
+            verts[j] = glm::vec3(vertices[pos], vertices[pos+1], vertices[pos+2]);
         }
         
-        glm::vec3 U = verts[i+1] - verts[i];
-        glm::vec3 V = verts[i+2] - verts[i];
+        glm::vec3 U = verts[1] - verts[0];
+        glm::vec3 V = verts[2] - verts[0];
         
         normal = glm::normalize(-glm::cross(U, V));
-        normals.push_back(normal.x);
-        normals.push_back(normal.y);
-        normals.push_back(normal.z);
+        for (int j = 0; j < 3; j++) {
+            vertexNormals[indices[i+j]] += normal;
+        }
     }
     
-    return normals;
+    for (int i = 0; i < vertexNormals.size(); i++) {
+        normal = glm::normalize(vertexNormals[i]);
+        out[i*3] = normal.x;
+        out[i*3 + 1] = normal.y;
+        out[i*3 + 2] = normal.z;
+    }
 }
 
-std::vector<float> generateBiome(const std::vector<float> &vertices, int xOffset, int yOffset) {
-    std::vector<float> colors;
+// We assign terrain based on height
+std::vector<terrainColor> biomeTable() {
     std::vector<terrainColor> biomeColors;
-    glm::vec3 color = glm::vec3(1, 1, 1);
     
-    // We assign terrain based on height
     biomeColors.push_back(terrainColor(WATER_HEIGHT * 0.5, deepWater));
     biomeColors.push_back(terrainColor(WATER_HEIGHT, shallowWater));
     biomeColors.push_back(terrainColor(0.15, sand));
@@ -210,6 +844,12 @@ std::vector<float> generateBiome(const std::vector<float> &vertices, int xOffset
     biomeColors.push_back(terrainColor(0.50, mountain1));
     biomeColors.push_back(terrainColor(0.80, mountain2));
     biomeColors.push_back(terrainColor(1.00, snow));
+    return biomeColors;
+}
+
+void generateBiome(const std::vector<float> &vertices, FloatSpan out) {
+    std::vector<terrainColor> biomeColors = biomeTable();
+    glm::vec3 color = glm::vec3(1, 1, 1);
 
     for (int i = 1; i < vertices.size(); i += 3) {
         for (int j = 0; j < biomeColors.size(); j++) {
@@ -218,54 +858,461 @@ std::vector<float> generateBiome(const std::vector<float> &vertices, int xOffset
                 break;
             }
         }
-        colors.push_back(color.r);
-        colors.push_back(color.g);
-        colors.push_back(color.b);
+        out[i - 1] = color.r;
+        out[i] = color.g;
+        out[i + 1] = color.b;
     }
-    return colors;
 }
 
-// Generate all data for a chunk and send it to GPU
-void generateMapChunk(GLuint &VAO, int xOffset, int yOffset) {
-    std::vector<int> indices;
+// Color of the terrain at a height, used by the far field
+glm::vec3 biomeColor(float height) {
+    std::vector<terrainColor> biomeColors = biomeTable();
+    for (int j = 0; j < biomeColors.size(); j++) {
+        if (height <= biomeColors[j].height * meshHeight) {
+            return biomeColors[j].color;
+        }
+    }
+    return biomeColors.back().color;
+}
+
+// Fingerprints of everything each generation stage depends on. A stage
+// includes the fingerprint of the stage it is built from, and the tag
+// should be bumped whenever the stage's code changes its output.
+// The permutation table is hashed rather than the seed, since std::shuffle
+// does not give the same table with every standard library.
+Fingerprint noiseConfig() {
+    Fingerprint config;
+    config.Add(std::string("noise-2")).Add(p).Add(octaves).Add(noiseScale)
+          .Add(persistence).Add(lacunarity).Add(chunkWidth).Add(chunkHeight);
+    return config;
+}
+
+Fingerprint meshConfig() {
+    Fingerprint config = noiseConfig();
+    config.Add(std::string("mesh-2")).Add(meshHeight);
+    return config;
+}
+
+Fingerprint normalsConfig() {
+    Fingerprint config = meshConfig();
+    config.Add(std::string("normals-1"));
+    return config;
+}
+
+Fingerprint lodConfig() {
+    Fingerprint config = meshConfig();
+    config.Add(std::string("lod-1"));
+    return config;
+}
+
+Fingerprint boundsConfig() {
+    Fingerprint config = meshConfig();
+    config.Add(std::string("bounds-3")).Add(occluderBlocks);
+    return config;
+}
+
+Fingerprint rtinConfig() {
+    Fingerprint config = meshConfig();
+    config.Add(std::string("rtin-2")).Add(rtinMaxError).Add(WATER_HEIGHT);
+    return config;
+}
+
+Fingerprint heightsConfig() {
+    Fingerprint config = noiseConfig();
+    config.Add(std::string("heights-1")).Add(meshHeight).Add(WATER_HEIGHT);
+    return config;
+}
+
+Fingerprint colorsConfig() {
+    Fingerprint config = meshConfig();
+    config.Add(std::string("colors-1"));
+    std::vector<terrainColor> biomeColors = biomeTable();
+    for (int i = 0; i < biomeColors.size(); i++) {
+        config.Add(biomeColors[i].height).Add(biomeColors[i].color.r)
+              .Add(biomeColors[i].color.g).Add(biomeColors[i].color.b);
+    }
+    return config;
+}
+
+// Precision noise maps are stored with, the same for every chunk so the
+// samples neighbours share are read back identically
+const float noiseStep = 1.0f / 65536.0f;
+
+// Read the noise map of a chunk from the store, or generate and store it.
+// Without a store it is always generated.
+// Payloads start with their cache key so stale entries are never used.
+std::vector<float> loadNoiseMap(ChunkStore *store, uint64_t key, int xOffset, int yOffset) {
+    std::vector<char> payload;
     std::vector<float> noise_map;
-    std::vector<float> vertices;
-    std::vector<float> normals;
-    std::vector<float> colors;
+    uint64_t storedKey = 0;
+    
+    if (!store) {
+        return generateNoiseMap(xOffset, yOffset);
+    }
+    if (store->Load(xOffset, yOffset, payload) && payload.size() > sizeof(storedKey)) {
+        std::memcpy(&storedKey, &payload[0], sizeof(storedKey));
+        if (storedKey == key && HeightCodec::Decode(&payload[sizeof(key)], payload.size() - sizeof(key), noise_map)
+            && noise_map.size() == chunkWidth * chunkHeight) {
+            return noise_map;
+        }
+    }
     
-    indices = generateIndices();
     noise_map = generateNoiseMap(xOffset, yOffset);
-    vertices = generateVertices(noise_map);
-    normals = generateNormals(indices, vertices);
-    colors = generateBiome(vertices, xOffset, yOffset);
+    std::vector<char> encoded = HeightCodec::Encode(&noise_map[0], chunkWidth, chunkHeight, noiseStep);
+    payload.resize(sizeof(key));
+    std::memcpy(&payload[0], &key, sizeof(key));
+    payload.insert(payload.end(), encoded.begin(), encoded.end());
+    store->Save(xOffset, yOffset, &payload[0], payload.size());
+    return noise_map;
+}
+
+// Parameters terrainColor (terrain.glsl) picks colors from
+void setBiomeUniforms(Shader &shader) {
+    shader.SetUniform1f("u_MeshHeight", meshHeight);
     
-    GLuint VBO[3], EBO;
+    std::vector<terrainColor> biomeColors = biomeTable();
+    std::vector<float> heights;
+    std::vector<float> colors;
+    for (int i = 0; i < biomeColors.size(); i++) {
+        heights.push_back(biomeColors[i].height);
+        colors.push_back(biomeColors[i].color.r);
+        colors.push_back(biomeColors[i].color.g);
+        colors.push_back(biomeColors[i].color.b);
+    }
+    shader.SetUniform1fv("u_BiomeHeights", heights.size(), &heights[0]);
+    shader.SetUniform3fv("u_BiomeColors", biomeColors.size(), &colors[0]);
+}
+
+// Parameters the terrain shaders (terrain.glsl) generate heights and colors from
+void setTerrainUniforms(Shader &shader) {
+    shader.SetUniform1iv("u_Perm", 256, &p[0]);
+    shader.SetUniform1i("u_Octaves", octaves);
+    shader.SetUniform1f("u_NoiseScale", noiseScale);
+    shader.SetUniform1f("u_Persistence", persistence);
+    shader.SetUniform1f("u_Lacunarity", lacunarity);
+    shader.SetUniform1f("u_WaterHeight", WATER_HEIGHT);
+    shader.SetUniform2f("u_NoiseOffset", chunkWidth / 2.0f, chunkHeight / 2.0f);
+    setBiomeUniforms(shader);
+}
+
+// Camera state of this frame, shared by every program. The projection is
+// only rebuilt and the block only uploaded when something changed.
+void updateFrameUniforms(FrameUniforms &frame, float nearPlane, float farPlane, glm::mat4 &view, glm::mat4 &projection) {
+    projection = frame.SetPerspective(glm::radians(45.0f), (float)gScreenWidth / (float)gScreenHeight, nearPlane, farPlane);
+    view = camera.GetViewMatrix();
+    frame.SetView(view, camera.m_eyePosition);
+    frame.Upload();
+}
+
+// Draw the terrain as a CDLOD quadtree, all heights come from the shader
+void renderCdlod(CdlodTerrain &cdlod, FrameUniforms &frame, Shader &shader, glm::mat4 &view, glm::mat4 &projection) {
+    glClearColor(0.53, 0.8, 0.92, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    
+    cdlod.Select(camera.m_eyePosition, 0.0f, meshHeight);
+    
+    shader.Bind();
+    updateFrameUniforms(frame, 1.0f, cdlod.GetViewDistance(), view, projection);
+    setTerrainUniforms(shader);
     
-    glGenBuffers(3, VBO);
-    glGenBuffers(1, &EBO);
-    glGenVertexArrays(1, &VAO);
+    cdlod.Render(shader);
+}
+
+// Draw the terrain as a geometry clipmap, generating what came into view
+void renderClipmap(GeometryClipmap &clipmap, FrameUniforms &frame, Shader &shader, glm::mat4 &view, glm::mat4 &projection) {
+    glClearColor(0.53, 0.8, 0.92, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), &vertices[0], GL_STATIC_DRAW);
+    clipmap.Update(camera.m_eyePosition);
     
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(int), &indices[0], GL_STATIC_DRAW);
+    shader.Bind();
+    updateFrameUniforms(frame, 1.0f, clipmap.GetViewDistance(), view, projection);
+    setBiomeUniforms(shader);
     
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    clipmap.Render(shader);
+}
+
+// Bring the height map layer of a chunk and its bounds up to date. Only
+// the height map is generated on the CPU, and only uploaded if it changed.
+void uploadHeightMap(mapChunk &chunk, HeightTextureArray &heights, ChunkPipeline &pipeline, int xOffset, int yOffset) {
+    uint64_t heightsKey = pipeline.GetKey(heightsStage, xOffset, yOffset);
+    if (chunk.heightsKey == heightsKey) {
+        return;
+    }
+    const std::vector<float> &heightMap = pipeline.Get(heightsStage, xOffset, yOffset);
+    heights.Upload(xOffset + yOffset*xMapChunks, &heightMap[0]);
+    chunk.heightsMin = *std::min_element(heightMap.begin(), heightMap.end());
+    chunk.heightsMax = *std::max_element(heightMap.begin(), heightMap.end());
+    chunk.heightsKey = heightsKey;
+}
+
+// Draw the chunks as tessellated patches
+void renderTessellated(TessellatedTerrain &tess, HeightTextureArray &heights, std::vector<mapChunk> &map_chunks, FrameUniforms &frame, Shader &shader, glm::mat4 &view, glm::mat4 &projection) {
+    glClearColor(0.53, 0.8, 0.92, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[1]);
-    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(float), &normals[0], GL_STATIC_DRAW);
+    shader.Bind();
+    updateFrameUniforms(frame, 0.1f, chunkViewDistance(), view, projection);
+    shader.SetUniform1f("u_ProjectionScale", gScreenHeight / (2.0f * std::tan(glm::radians(45.0f) / 2.0f)));
+    shader.SetUniform1f("u_PixelsPerSegment", tessPixelsPerSegment);
+    setBiomeUniforms(shader);
     
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
+    Frustum frustum(projection * view);
+    tess.Bind(shader, heights);
+    for (int y = 0; y < yMapChunks; y++) {
+        for (int x = 0; x < xMapChunks; x++) {
+            glm::vec3 min, max;
+            heightMapBounds(map_chunks[x + y*xMapChunks], x, y, min, max);
+            if (frustum.Intersects(min, max)) {
+                tess.Draw(x + y*xMapChunks, chunkOrigin(x, y));
+            }
+        }
+    }
+}
+
+// Draw the chunks as one shared grid, pulling every vertex's height from
+// the chunk's height map. All visible chunks are instances of one draw.
+void renderHeightmap(HeightmapTerrain &terrain, HeightTextureArray &heights, std::vector<mapChunk> &map_chunks, FrameUniforms &frame, Shader &shader, glm::mat4 &view, glm::mat4 &projection) {
+    glClearColor(0.53, 0.8, 0.92, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[2]);
-    glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(float), &colors[0], GL_STATIC_DRAW);
+    shader.Bind();
+    updateFrameUniforms(frame, 0.1f, chunkViewDistance(), view, projection);
+    setBiomeUniforms(shader);
     
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(2);
+    Frustum frustum(projection * view);
+    std::vector<glm::vec4> chunks;
+    for (int y = 0; y < yMapChunks; y++) {
+        for (int x = 0; x < xMapChunks; x++) {
+            glm::vec3 min, max;
+            heightMapBounds(map_chunks[x + y*xMapChunks], x, y, min, max);
+            if (frustum.Intersects(min, max)) {
+                chunks.push_back(glm::vec4(chunkOrigin(x, y), x + y*xMapChunks));
+            }
+        }
+    }
+    terrain.Bind(shader, heights);
+    terrain.Draw(chunks);
+}
+
+// Reports how well HeightCodec does on real chunks (run with --bench-codec)
+void runCodecBenchmark() {
+    const int iterations = 20;
+    std::vector<std::vector<float>> noise_maps;
+    std::vector<std::vector<char>> encoded;
+    
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            noise_maps.push_back(generateNoiseMap(x, y));
+        }
+    }
+    encoded.resize(noise_maps.size());
+    
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (int c = 0; c < noise_maps.size(); c++) {
+            encoded[c] = HeightCodec::Encode(&noise_maps[c][0], chunkWidth, chunkHeight, noiseStep);
+        }
+    }
+    double encodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    std::vector<float> decoded;
+    float maxError = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (int c = 0; c < encoded.size(); c++) {
+            HeightCodec::Decode(&encoded[c][0], encoded[c].size(), decoded);
+        }
+    }
+    double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    size_t rawBytes = 0;
+    size_t encodedBytes = 0;
+    for (int c = 0; c < noise_maps.size(); c++) {
+        HeightCodec::Decode(&encoded[c][0], encoded[c].size(), decoded);
+        for (int i = 0; i < decoded.size(); i++) {
+            maxError = std::fmax(maxError, std::fabs(decoded[i] - noise_maps[c][i]));
+        }
+        rawBytes += noise_maps[c].size() * sizeof(float);
+        encodedBytes += encoded[c].size();
+    }
+    
+    double megabytes = (double)rawBytes * iterations / (1024.0 * 1024.0);
+    std::cout << "Chunks:     " << noise_maps.size() << " (" << chunkWidth << "x" << chunkHeight << ")\n";
+    std::cout << "Raw size:   " << rawBytes / noise_maps.size() << " bytes per chunk\n";
+    std::cout << "Encoded:    " << encodedBytes / noise_maps.size() << " bytes per chunk\n";
+    std::cout << "Ratio:      " << (double)rawBytes / encodedBytes << ":1\n";
+    std::cout << "Encode:     " << megabytes / encodeSeconds << " MB/s\n";
+    std::cout << "Decode:     " << megabytes / decodeSeconds << " MB/s\n";
+    std::cout << "Max error:  " << maxError << "\n";
+}
+
+// Reports how much RtinMesh saves on real chunks (run with --bench-rtin)
+void runRtinBenchmark() {
+    const int iterations = 10;
+    RtinMesh rtin(chunkWidth);
+    std::vector<std::vector<float>> meshes;
+    
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            meshes.push_back(std::vector<float>(chunkAttributeSize()));
+            generateVertices(generateNoiseMap(x, y), FloatSpan(meshes.back()));
+        }
+    }
+    
+    std::vector<std::vector<float>> errors(meshes.size());
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (int c = 0; c < meshes.size(); c++) {
+            errors[c] = rtin.ComputeErrors(&meshes[c][1], 3);
+        }
+    }
+    double errorsSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    float thresholds[4] = { 0.1f, 0.25f, 0.5f, 1.0f };
+    size_t fullTriangles = (size_t)(chunkWidth - 1) * (chunkHeight - 1) * 2;
+    std::cout << "Chunks:     " << meshes.size() << " (" << chunkWidth << "x" << chunkHeight << ", "
+              << fullTriangles << " triangles at full resolution)\n";
+    std::cout << "Errors:     " << errorsSeconds * 1000.0 / (iterations * meshes.size()) << " ms per chunk\n";
+    for (int t = 0; t < 4; t++) {
+        size_t triangles = 0;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            triangles = 0;
+            for (int c = 0; c < meshes.size(); c++) {
+                triangles += rtin.Triangulate(errors[c], thresholds[t]).size() / 3;
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Max error " << thresholds[t] << ": " << triangles / meshes.size() << " triangles per chunk, "
+                  << 100.0 - 100.0 * triangles / (fullTriangles * meshes.size()) << "% fewer, "
+                  << seconds * 1000.0 / (iterations * meshes.size()) << " ms per chunk\n";
+    }
+    
+    size_t aboveWater = 0;
+    for (int c = 0; c < meshes.size(); c++) {
+        aboveWater += generateRtin(rtin, meshes[c]).size() / 3;
+    }
+    std::cout << "Above water: " << aboveWater / meshes.size() << " triangles per chunk at max error " << rtinMaxError << "\n";
+}
+
+// Declare the generation stages and the parameters each one depends on
+void buildPipeline(ChunkPipeline &pipeline, ChunkStore *store, const std::vector<int> &indices, const RtinMesh &rtin) {
+    typedef const std::vector<const std::vector<float>*> Inputs;
+    
+    noiseStage = pipeline.AddStage("noise", noiseConfig, {},
+        [store](int x, int y, uint64_t key, Inputs &/*inputs*/) { return loadNoiseMap(store, key, x, y); });
+    meshStage = pipeline.AddStage("mesh", meshConfig, {noiseStage}, chunkAttributeSize(),
+        [](int /*x*/, int /*y*/, uint64_t /*key*/, Inputs &inputs, FloatSpan out) { generateVertices(*inputs[0], out); });
+    normalsStage = pipeline.AddStage("normals", normalsConfig, {meshStage}, chunkAttributeSize(),
+        [&indices](int /*x*/, int /*y*/, uint64_t /*key*/, Inputs &inputs, FloatSpan out) { generateNormals(indices, *inputs[0], out); });
+    colorsStage = pipeline.AddStage("colors", colorsConfig, {meshStage}, chunkAttributeSize(),
+        [](int /*x*/, int /*y*/, uint64_t /*key*/, Inputs &inputs, FloatSpan out) { generateBiome(*inputs[0], out); });
+    lodStage = pipeline.AddStage("lod", lodConfig, {meshStage},
+        [](int /*x*/, int /*y*/, uint64_t /*key*/, Inputs &inputs) { return ChunkLod::ComputeErrors(*inputs[0], chunkWidth - 1); });
+    boundsStage = pipeline.AddStage("bounds", boundsConfig, {meshStage},
+        [](int /*x*/, int /*y*/, uint64_t /*key*/, Inputs &inputs) { return generateBounds(*inputs[0]); });
+    rtinStage = pipeline.AddStage("rtin", rtinConfig, {meshStage},
+        [&rtin](int /*x*/, int /*y*/, uint64_t /*key*/, Inputs &inputs) { return generateRtin(rtin, *inputs[0]); });
+    heightsStage = pipeline.AddStage("heights", heightsConfig, {noiseStage},
+        [](int /*x*/, int /*y*/, uint64_t /*key*/, Inputs &inputs) { return generateHeightMap(*inputs[0]); });
+}
+
+// Write a stage straight into staging memory for an attribute of a slot.
+// If the memory could not be mapped or was lost, the stage's cached
+// output is uploaded instead.
+void writeAttribute(int slot, int attribute, ChunkArena &arena, ChunkPipeline &pipeline, int stage, int xOffset, int yOffset) {
+    FloatSpan span = arena.MapAttribute(slot, attribute);
+    bool written = span.data && pipeline.Write(stage, xOffset, yOffset, span);
+    bool sent = arena.UnmapAttribute();
+    if (!written || !sent) {
+        arena.UploadAttribute(slot, attribute, &pipeline.Get(stage, xOffset, yOffset)[0]);
+    }
+}
+
+// Bring the GPU data of a chunk up to date. Only the stages whose
+// parameters changed since the last upload are run and uploaded again.
+void generateMapChunk(mapChunk &chunk, ChunkArena &arena, ChunkPipeline &pipeline, int xOffset, int yOffset) {
+    if (chunk.slot < 0) {
+        chunk.slot = arena.Allocate();
+        arena.SetOrigin(chunk.slot, chunkOrigin(xOffset, yOffset));
+    }
+    
+    uint64_t meshKey = pipeline.GetKey(meshStage, xOffset, yOffset);
+    if (chunk.meshKey != meshKey) {
+        arena.UploadAttribute(chunk.slot, ChunkArena::POSITION, &pipeline.Get(meshStage, xOffset, yOffset)[0]);
+        chunk.meshKey = meshKey;
+    }
+    
+    // Normals and colors are only read by the GPU, so they are written
+    // straight into staging memory instead of being kept around
+    uint64_t normalsKey = pipeline.GetKey(normalsStage, xOffset, yOffset);
+    if (chunk.normalsKey != normalsKey) {
+        writeAttribute(chunk.slot, ChunkArena::NORMAL, arena, pipeline, normalsStage, xOffset, yOffset);
+        chunk.normalsKey = normalsKey;
+    }
+    
+    uint64_t colorsKey = pipeline.GetKey(colorsStage, xOffset, yOffset);
+    if (chunk.colorsKey != colorsKey) {
+        writeAttribute(chunk.slot, ChunkArena::COLOR, arena, pipeline, colorsStage, xOffset, yOffset);
+        chunk.colorsKey = colorsKey;
+    }
+    
+    uint64_t rtinKey = pipeline.GetKey(rtinStage, xOffset, yOffset);
+    if (chunk.rtinKey != rtinKey) {
+        const std::vector<float> &triangles = pipeline.Get(rtinStage, xOffset, yOffset);
+        arena.FreeIndices(chunk.rtinFirst, chunk.rtinCount);
+        // The stage holds the indices' bits, see generateRtin
+        chunk.rtinFirst = arena.AllocateIndices((const int*)triangles.data(), triangles.size());
+        chunk.rtinCount = triangles.size();
+        chunk.rtinKey = rtinKey;
+    }
+    
+    chunk.lodErrors = pipeline.Get(lodStage, xOffset, yOffset);
+    
+    const std::vector<float> &bounds = pipeline.Get(boundsStage, xOffset, yOffset);
+    chunk.minHeight = bounds[0];
+    chunk.maxHeight = bounds[1];
+    int blocks = occluderBlocks * occluderBlocks;
+    chunk.occluderHeights.assign(bounds.begin() + 2, bounds.begin() + 2 + blocks);
+    chunk.blockMaxHeights.assign(bounds.begin() + 2 + blocks, bounds.end());
+}
+
+// Re-run whatever the current parameters invalidated for the current
+// mode and report it. The chunk grid needs the CPU meshes, the modes
+// that build their vertices on the GPU only the height maps, and the
+// others no chunks at all.
+void regenerateMap(std::vector<mapChunk> &map_chunks, ChunkArena &arena, HeightTextureArray &heights, ChunkPipeline &pipeline) {
+    auto start = std::chrono::steady_clock::now();
+    
+    pipeline.Refresh();
+    mapMode = terrainMode;
+    // The height maps start at the water level, and every parameter the
+    // range depends on also changes every layer's heights key
+    heights.SetRange(waterLevel(), maxTerrainHeight());
+    if (terrainMode == CHUNK_GRID_MODE) {
+        chunkBoxes.Resize(map_chunks.size());
+    }
+    for (int y = 0; y < yMapChunks; y++) {
+        for (int x = 0; x < xMapChunks; x++) {
+            mapChunk &chunk = map_chunks[x + y*xMapChunks];
+            if (terrainMode == CHUNK_GRID_MODE) {
+                generateMapChunk(chunk, arena, pipeline, x, y);
+                glm::vec3 min, max;
+                chunkBounds(chunk, x, y, min, max);
+                chunkBoxes.Set(x + y*xMapChunks, min, max);
+            } else if (terrainMode == TESSELLATION_MODE || terrainMode == HEIGHTMAP_MODE) {
+                uploadHeightMap(chunk, heights, pipeline, x, y);
+            }
+        }
+    }
+    
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Regenerated in " << ms << " ms (";
+    int stages = pipeline.GetStageCount();
+    for (int i = 0; i < stages; i++) {
+        std::cout << pipeline.GetName(i) << ": " << pipeline.TakeRunCount(i) << (i < stages - 1 ? ", " : ")\n");
+    }
 }
 
 // Initialize SDL and GLAD
@@ -315,75 +1362,268 @@ void InitializeProgram() {
     glEnable(GL_FRAMEBUFFER_SRGB);
 
     // Set swap interval for vertical sync
-    SDL_GL_SetSwapInterval(1);
+    SDL_GL_SetSwapInterval(vsyncEnabled ? 1 : 0);
 }
 
-int main() {
+// Whether 'key' went down since the previous simulation step
+bool keyPressed(const Uint8* state, SDL_Scancode key) {
+    return state[key] && !previousKeys[key];
+}
+
+// Advance the simulation by one fixed step of 'step' seconds, the
+// keyboard is read once per step. Returns whether the terrain
+// parameters changed.
+bool updateSimulation(float step) {
+    const Uint8* state = SDL_GetKeyboardState(NULL);
+    bool parametersChanged = false;
+
+    // Quit application
+    if (state[SDL_SCANCODE_Q]) {
+        quit = true;
+    }
+
+    // Enable wireframe mode
+    if (state[SDL_SCANCODE_E]) {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    }
+    // Disable wireframe mode
+    if (state[SDL_SCANCODE_R]) {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    }
+
+    // Switch between terrain modes
+    if (state[SDL_SCANCODE_1]) {
+        terrainMode = CHUNK_GRID_MODE;
+    }
+    if (state[SDL_SCANCODE_2]) {
+        terrainMode = CDLOD_MODE;
+    }
+    if (state[SDL_SCANCODE_3]) {
+        terrainMode = CLIPMAP_MODE;
+    }
+    if (state[SDL_SCANCODE_4]) {
+        terrainMode = TESSELLATION_MODE;
+    }
+    if (state[SDL_SCANCODE_5]) {
+        terrainMode = HEIGHTMAP_MODE;
+    }
+
+    // Enable and disable horizon culling
+    if (state[SDL_SCANCODE_O]) {
+        horizonCulling = true;
+    }
+    if (state[SDL_SCANCODE_N]) {
+        horizonCulling = false;
+    }
+
+    // Enable and disable occlusion culling
+    if (state[SDL_SCANCODE_H]) {
+        occlusionCulling = true;
+    }
+    if (state[SDL_SCANCODE_G]) {
+        occlusionCulling = false;
+    }
+
+    // Enable and disable the depth pre-pass
+    if (state[SDL_SCANCODE_Z]) {
+        depthPrepass = true;
+    }
+    if (state[SDL_SCANCODE_X]) {
+        depthPrepass = false;
+    }
+
+    // Enable and disable level of detail
+    if (state[SDL_SCANCODE_L]) {
+        lodEnabled = true;
+    }
+    if (state[SDL_SCANCODE_P]) {
+        lodEnabled = false;
+    }
+
+    // Enable and disable the far field
+    if (state[SDL_SCANCODE_F]) {
+        farFieldEnabled = true;
+    }
+    if (state[SDL_SCANCODE_V]) {
+        farFieldEnabled = false;
+    }
+
+    // Switch between level of detail and adaptive triangulation
+    if (state[SDL_SCANCODE_T]) {
+        rtinEnabled = true;
+    }
+    if (state[SDL_SCANCODE_Y]) {
+        rtinEnabled = false;
+    }
+
+    // Live terrain tuning, one step per key press since every change
+    // regenerates the terrain
+    if (keyPressed(state, SDL_SCANCODE_U)) {
+        meshHeight += 1;
+        parametersChanged = true;
+    }
+    if (keyPressed(state, SDL_SCANCODE_J)) {
+        meshHeight = std::fmax(meshHeight - 1, 1.0f);
+        parametersChanged = true;
+    }
+    if (keyPressed(state, SDL_SCANCODE_I)) {
+        WATER_HEIGHT = std::fmin(WATER_HEIGHT + 0.01f, 1.0f);
+        parametersChanged = true;
+    }
+    if (keyPressed(state, SDL_SCANCODE_K)) {
+        WATER_HEIGHT = std::fmax(WATER_HEIGHT - 0.01f, 0.0f);
+        parametersChanged = true;
+    }
+
+    // Camera movement
+    if (state[SDL_SCANCODE_W]) {
+        camera.MoveForward(cameraSpeed * step);
+    }
+    if (state[SDL_SCANCODE_S]) {
+        camera.MoveBackward(cameraSpeed * step);
+    }
+    if (state[SDL_SCANCODE_A]) {
+        camera.MoveLeft(cameraSpeed * step);
+    }
+    if (state[SDL_SCANCODE_D]) {
+        camera.MoveRight(cameraSpeed * step);
+    }
+
+    // Enable and disable vertical sync
+    bool vsync = vsyncEnabled;
+    if (state[SDL_SCANCODE_C]) {
+        vsync = true;
+    }
+    if (state[SDL_SCANCODE_B]) {
+        vsync = false;
+    }
+    if (vsync != vsyncEnabled) {
+        vsyncEnabled = vsync;
+        SDL_GL_SetSwapInterval(vsyncEnabled ? 1 : 0);
+    }
+    
+    std::memcpy(previousKeys, state, SDL_NUM_SCANCODES);
+    return parametersChanged;
+}
+
+// Print the spread of the recent frame times
+void reportFrameStats(const FrameClock &clock) {
+    FrameClock::Stats stats = clock.GetStats();
+    std::cout << "Frame times over " << stats.frames << " frames: " << stats.average << " ms average ("
+              << 1000.0 / std::max(stats.average, 0.001) << " fps), " << stats.best << " ms best, "
+              << stats.percentile99 << " ms at the 99th percentile, " << stats.worst << " ms worst" << std::endl;
+}
+
+// Owns every GL object, so they are all released before the context is destroyed
+void RunProgram() {
     glm::mat4 view;
-    glm::mat4 model;
     glm::mat4 projection;
 
-    InitializeProgram();
+    // Camera and light blocks every program reads
+    FrameUniforms frame;
+    frame.SetLight(glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(0.4f), glm::vec3(0.3f), glm::vec3(0.5f));
+    
+    // Programs linked by earlier runs on the same driver are loaded back
+    // instead of compiled
+    auto programsStart = std::chrono::steady_clock::now();
+    Shader::SetBinaryCache("./world/programs");
     
     Shader shader;
     shader.CreateShader("./shaders/vert.glsl", "./shaders/frag.glsl");
+    frame.Attach(shader);
+    shader.Bind();
+    shader.SetUniform1i("u_SlotOrigins", 0);
     
+    // Same vertices with nothing to shade, for the depth pre-pass
+    Shader depthShader;
+    depthShader.CreateShader("./shaders/vert.glsl", "./shaders/depth_frag.glsl");
+    frame.Attach(depthShader);
+    depthShader.Bind();
+    depthShader.SetUniform1i("u_SlotOrigins", 0);
     shader.Bind();
     
-    shader.SetUniform3f("u_Light.lightPos", 0.0f, 10.0f, 0.0f);
-    shader.SetUniform3f("u_Light.ambient", 0.4, 0.4, 0.4);
-    shader.SetUniform3f("u_Light.diffuse", 0.3, 0.3, 0.3);
-    shader.SetUniform3f("u_Light.specular", 0.5, 0.5, 0.5);
+    // Quadtree terrain reaching out about 65 km (10 levels of 64 unit leaves)
+    Shader cdlodShader;
+    cdlodShader.CreateShader("./shaders/cdlod_vert.glsl", "./shaders/frag.glsl");
+    frame.Attach(cdlodShader);
+    CdlodTerrain cdlod(64, 64.0f, 10, glm::vec2(originX, originY));
     
-    std::vector<GLuint> map_chunks(xMapChunks * yMapChunks);
+    // Clipmap levels of 256^2 heights, reaching out about 65 km as well
+    Shader clipmapShader;
+    clipmapShader.CreateShader("./shaders/clipmap_vert.glsl", "./shaders/clipmap_frag.glsl");
+    frame.Attach(clipmapShader);
+    GeometryClipmap clipmap(10, 256, 1.0f, generateHeights);
     
-    for (int y = 0; y < yMapChunks; y++) {
-        for (int x = 0; x < xMapChunks; x++) {
-            generateMapChunk(map_chunks[x + y*xMapChunks], x, y);
-        }
+    // Chunks as 16^2 patches of 8^2 cells, tessellated back up to full resolution
+    Shader tessShader;
+    tessShader.CreateShader("./shaders/tess_vert.glsl", "./shaders/tess_ctrl.glsl", "./shaders/tess_eval.glsl", "./shaders/frag.glsl");
+    frame.Attach(tessShader);
+    TessellatedTerrain tess(chunkWidth - 1, 8);
+    
+    // Chunks as one full resolution grid displaced by their heights
+    Shader heightmapShader;
+    heightmapShader.CreateShader("./shaders/heightmap_vert.glsl", "./shaders/frag.glsl");
+    frame.Attach(heightmapShader);
+    HeightmapTerrain heightmap(chunkWidth - 1);
+    
+    double programsMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - programsStart).count();
+    std::cout << "Programs ready in " << programsMs << " ms" << std::endl;
+    
+    // Chunk heights shared by both of them, one layer per chunk
+    HeightTextureArray heightTextures(chunkWidth, xMapChunks * yMapChunks);
+    
+    // Full resolution triangles, used to build the normals
+    std::vector<int> indices = generateIndices();
+    ChunkArena arena(chunkWidth * chunkHeight, xMapChunks * yMapChunks);
+    ChunkLod lod(arena, chunkWidth - 1, occluderBlocks);
+    RtinMesh rtin(chunkWidth);
+    WaterPlane water(32, 2.0f * chunkWidth * chunk_render_distance, deepWater);
+    // Tiles of 32^2 cells 16 units apart, out to about 5 km
+    FarFieldRing farField(32, 16.0f, 10, generateHeights, biomeColor);
+    HorizonCuller horizon(2048);
+    OcclusionRasterizer occlusion(320, 180, std::max(1u, std::min(std::thread::hardware_concurrency(), 4u)));
+    // Prepare the chunk draws off the GL thread
+    WorkerPool workers(std::max(1u, std::min(std::thread::hardware_concurrency(), 4u)));
+    
+    // Chunks generated by earlier runs (or machines) with the same noise
+    // parameters are read back instead of regenerated. A random seed
+    // would leave a store behind that no later run reads, so its chunks
+    // are only kept in memory.
+    std::unique_ptr<ChunkStore> store;
+    if (seedGiven) {
+        store.reset(new ChunkStore("./world/noise-" + noiseConfig().ToString()));
     }
     
-    int nIndices = chunkWidth * chunkHeight * 6;
+    ChunkPipeline pipeline;
+    buildPipeline(pipeline, store.get(), indices, rtin);
+    
+    std::vector<mapChunk> map_chunks(xMapChunks * yMapChunks);
+    regenerateMap(map_chunks, arena, heightTextures, pipeline);
+    
 
-    // Main loop
+    // Main loop. The simulation advances in fixed steps and frames are
+    // drawn in between, with the camera interpolated between the last
+    // two steps.
+    FrameClock clock(1.0 / 60.0, 1000);
+    glm::vec3 previousEye = camera.m_eyePosition;
+    auto lastReport = std::chrono::steady_clock::now();
+    
+    // Frames are read back three frames late, with up to eight waiting
+    // to be written
+    FrameCapture capture(gScreenWidth, gScreenHeight, 3, 8);
+    if (!capturePath.empty()) {
+        capture.Start(captureFormat, capturePath);
+    }
     SDL_Event e;
     while (!quit) {
+        clock.BeginFrame();
+        
         // Handle events on queue
         while (SDL_PollEvent(&e) != 0) {
             // User requests quit
             if (e.type == SDL_QUIT) {
                 quit = true;
             }
-            const Uint8* state = SDL_GetKeyboardState(NULL);
-
-            // Quit application
-            if (state[SDL_SCANCODE_Q]) {
-                quit = true;
-            }
-
-            // Enable wireframe mode
-            if (state[SDL_SCANCODE_E]) {
-                glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-            }
-            // Disable wireframe mode
-            if (state[SDL_SCANCODE_R]) {
-                glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            }
-
-            // Camera movement
-            if (state[SDL_SCANCODE_W]) {
-                camera.MoveForward(1);
-            }
-            if (state[SDL_SCANCODE_S]) {
-                camera.MoveBackward(1);
-            }
-            if (state[SDL_SCANCODE_A]) {
-                camera.MoveLeft(1);
-            }
-            if (state[SDL_SCANCODE_D]) {
-                camera.MoveRight(1);
-            }
-
             // Mouse movement
             if (e.type == SDL_MOUSEMOTION) {
                 mouseX += e.motion.xrel;
@@ -391,25 +1631,110 @@ int main() {
                 camera.MouseLook(mouseX, mouseY);
             }
         }
+        
+        bool parametersChanged = false;
+        while (clock.Step()) {
+            previousEye = camera.m_eyePosition;
+            parametersChanged |= updateSimulation(clock.GetStep());
+        }
 
-        shader.Bind();
-        projection = glm::perspective(glm::radians(45.0f), (float)gScreenWidth / (float)gScreenHeight, 0.1f, (float)chunkWidth * (chunk_render_distance - 1.2f));
-        view = camera.GetViewMatrix();
-        shader.SetUniformMatrix4fv("u_Projection", &projection[0][0]);
-        shader.SetUniformMatrix4fv("u_ViewMatrix", &view[0][0]);
-        shader.SetUniform3f("u_ViewPos", camera.GetEyeXPosition(), camera.GetEyeYPosition(), camera.GetEyeZPosition());
+        // Only the stages affected by the change are run again, and only
+        // for the mode being drawn, so a mode switch catches up on what
+        // the new mode needs
+        if (parametersChanged || terrainMode != mapMode) {
+            regenerateMap(map_chunks, arena, heightTextures, pipeline);
+        }
+        if (parametersChanged) {
+            clipmap.Invalidate();
+            farField.Invalidate();
+        }
+
+        // Draw from where the camera is between the last two steps
+        glm::vec3 simulatedEye = camera.m_eyePosition;
+        camera.m_eyePosition = glm::mix(previousEye, simulatedEye, clock.GetAlpha());
         
-        render(map_chunks, shader, view, model, projection, nIndices);
+        if (terrainMode == CDLOD_MODE) {
+            renderCdlod(cdlod, frame, cdlodShader, view, projection);
+        } else if (terrainMode == CLIPMAP_MODE) {
+            renderClipmap(clipmap, frame, clipmapShader, view, projection);
+        } else if (terrainMode == TESSELLATION_MODE) {
+            renderTessellated(tess, heightTextures, map_chunks, frame, tessShader, view, projection);
+        } else if (terrainMode == HEIGHTMAP_MODE) {
+            renderHeightmap(heightmap, heightTextures, map_chunks, frame, heightmapShader, view, projection);
+        } else {
+            shader.Bind();
+            updateFrameUniforms(frame, 0.1f, chunkViewDistance(), view, projection);
+            
+            render(map_chunks, arena, lod, horizon, occlusion, water, farField, workers, frame, shader, depthShader, view, projection);
+        }
+
+        camera.m_eyePosition = simulatedEye;
+        capture.Capture();
 
         // Update window
         SDL_GL_SwapWindow(window);
+        clock.Pace(fpsCap);
+        
+        if (std::chrono::steady_clock::now() - lastReport > std::chrono::duration<float>(statsInterval)) {
+            lastReport = std::chrono::steady_clock::now();
+            reportFrameStats(clock);
+        }
     }
+    reportFrameStats(clock);
+    capture.Stop();
     
     for (int i = 0; i < map_chunks.size(); i++) {
-        glDeleteVertexArrays(1, &map_chunks[i]);
+        if (map_chunks[i].slot >= 0) {
+            arena.Free(map_chunks[i].slot);
+        }
+        arena.FreeIndices(map_chunks[i].rtinFirst, map_chunks[i].rtinCount);
     }
 
     shader.Unbind();
+}
+
+int main(int argc, char* argv[]) {
+    // A fixed seed gives the same world (and reuses its stored chunks)
+    seed = std::random_device()();
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--seed" && i + 1 < argc) {
+            seed = std::strtoul(argv[++i], nullptr, 10);
+            seedGiven = true;
+        }
+        // Frames as fast as they come, or at most this many per second
+        if (std::string(argv[i]) == "--no-vsync") {
+            vsyncEnabled = false;
+        }
+        if (std::string(argv[i]) == "--fps-cap" && i + 1 < argc) {
+            fpsCap = std::strtof(argv[++i], nullptr);
+        }
+        // Capture every frame as PPM images in a directory, or as raw video
+        if (std::string(argv[i]) == "--capture" && i + 1 < argc) {
+            capturePath = argv[++i];
+            captureFormat = FrameCapture::PPM_FRAMES;
+        }
+        if (std::string(argv[i]) == "--capture-raw" && i + 1 < argc) {
+            capturePath = argv[++i];
+            captureFormat = FrameCapture::RAW_VIDEO;
+        }
+    }
+    std::cout << "Seed: " << seed << std::endl;
+    p = getPermutationVector(seed);
+    
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--bench-codec") {
+            runCodecBenchmark();
+            return 0;
+        }
+        if (std::string(argv[i]) == "--bench-rtin") {
+            runRtinBenchmark();
+            return 0;
+        }
+    }
+    
+    InitializeProgram();
+    
+    RunProgram();
     
     // Destroy window
     SDL_GL_DeleteContext(glContext);